@@ -0,0 +1,35 @@
+#pragma once
+#include <psl/chrono.h>
+
+// Helpers shared by the microbenchmarks; timings are printed, nothing is checked
+
+namespace bench {
+
+// The best of `runs` timings of `f`, in milliseconds
+template <typename F>
+double best_ms(int runs, F f) {
+  auto best = 1e30;
+  for (int i = 0; i < runs; i++) {
+    auto clock = psl::clock();
+    f();
+    auto ms = clock.now() * 1000.0;
+    best = ms < best ? ms : best;
+  }
+  return best;
+}
+
+// Make the compiler assume `x` is read and written, so work that produces it isn't dropped or
+// hoisted out of a loop
+template <typename T>
+void keep(T& x) {
+  asm volatile("" : : "r"(&x) : "memory");
+}
+
+// `x` as a value the compiler can't see through, so it can't specialize on it
+template <typename T>
+T opaque(T x) {
+  asm volatile("" : "+r"(x));
+  return x;
+}
+
+}  // namespace bench
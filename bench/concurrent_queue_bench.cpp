@@ -0,0 +1,89 @@
+#include "bench.h"
+
+#include <psl/concurrent_queue.h>
+#include <psl/thread.h>
+#include <psl/vector.h>
+
+#include <cstdio>
+#include <deque>
+#include <mutex>
+
+// Throughput of 1024-slot queues of uint64_t in millions of items a second: spsc_queue with one
+// producer and one consumer, then mpmc_queue against a std::mutex around a std::deque with half
+// the threads producing and half consuming. A side that finds the queue full or empty yields, so
+// the numbers mean something on machines with fewer cores than threads
+
+constexpr int capacity = 1024;
+
+// A std::deque behind a std::mutex, bounded like the lock-free queues
+class LockedQueue {
+public:
+  explicit LockedQueue(size_t capacity) : capacity(capacity) {}
+
+  bool try_push(uint64_t x) {
+    auto lock = std::lock_guard(mutex);
+    if (items.size() == capacity)
+      return false;
+    items.push_back(x);
+    return true;
+  }
+  psl::optional<uint64_t> try_pop() {
+    auto lock = std::lock_guard(mutex);
+    if (items.empty())
+      return psl::nullopt;
+    auto x = items.front();
+    items.pop_front();
+    return x;
+  }
+
+private:
+  std::mutex mutex;
+  std::deque<uint64_t> items;
+  size_t capacity;
+};
+
+// Push `n_items` through `queue` with `n_producers` and `n_consumers` threads, returns Mops/s
+template <typename Queue>
+double throughput(Queue& queue, int n_producers, int n_consumers, int64_t n_items) {
+  auto ms = bench::best_ms(3, [&] {
+    auto threads = psl::vector<psl::thread>();
+    auto sum = psl::atomic<uint64_t>(0);
+    for (int p = 0; p < n_producers; p++)
+      threads.push_back(psl::thread([&, p] {
+        for (int64_t i = p; i < n_items; i += n_producers)
+          while (!queue.try_push(uint64_t(i)))
+            psl::this_thread_yield();
+      }));
+    for (int c = 0; c < n_consumers; c++)
+      threads.push_back(psl::thread([&, c] {
+        uint64_t local = 0;
+        for (int64_t i = c; i < n_items; i += n_consumers) {
+          auto x = queue.try_pop();
+          while (!x) {
+            psl::this_thread_yield();
+            x = queue.try_pop();
+          }
+          local += *x;
+        }
+        sum.fetch_add(local);
+      }));
+    for (auto& thread : threads)
+      thread.join();
+    bench::keep(sum);
+  });
+  return n_items / (ms * 1e3);
+}
+
+int main() {
+  auto spsc = psl::spsc_queue<uint64_t>(capacity);
+  printf("spsc 1p/1c  %6.1f Mops/s\n", throughput(spsc, 1, 1, 16 << 20));
+
+  printf("%-8s %12s %14s   (Mops/s)\n", "threads", "mpmc", "mutex+deque");
+  for (int n_threads : {2, 4, 8, 16}) {
+    auto mpmc = psl::mpmc_queue<uint64_t>(capacity);
+    auto locked = LockedQueue(capacity);
+    printf("%-8d %12.1f %14.1f\n", n_threads,
+           throughput(mpmc, n_threads / 2, n_threads / 2, 4 << 20),
+           throughput(locked, n_threads / 2, n_threads / 2, 4 << 20));
+  }
+}
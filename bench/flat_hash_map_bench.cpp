@@ -0,0 +1,84 @@
+#include "bench.h"
+
+#include <pine/rng.h>
+
+#include <psl/flat_hash_map.h>
+#include <psl/unordered_map.h>
+#include <psl/vector.h>
+
+#include <cstdio>
+
+// psl::flat_hash_map against psl::unordered_map, the std-backed wrapper, with 1M random uint64
+// keys: inserting them, 4M lookups that hit and 4M that miss, 4 passes over the entries, erasing
+// them all, and 1M lookups over 1k keys that stay in cache
+
+constexpr int n_keys = 1 << 20;
+
+// The best of 5 timings of `f` on a map from `make`; neither making nor destroying it is timed
+template <typename Make, typename F>
+double best_ms_on(Make make, F f) {
+  auto best = 1e30;
+  for (int run = 0; run < 5; run++) {
+    auto map = make();
+    auto ms = bench::best_ms(1, [&] { f(map); });
+    best = ms < best ? ms : best;
+  }
+  return best;
+}
+
+template <typename Map>
+void run(const char* name, const psl::vector<uint64_t>& keys, const psl::vector<uint64_t>& misses) {
+  auto fill = [&](Map& map) {
+    for (int i = 0; i < n_keys; i++)
+      map[keys[i]] = i;
+  };
+  auto build = [&] {
+    auto map = Map();
+    fill(map);
+    return map;
+  };
+  auto insert = best_ms_on([] { return Map(); }, fill);
+
+  auto map = build();
+  auto lookups = [&](const psl::vector<uint64_t>& queries, int n, int mask) {
+    return bench::best_ms(5, [&] {
+      auto found = 0;
+      for (int i = 0; i < n; i++)
+        found += map.find(queries[i & mask]) != map.end();
+      bench::keep(found);
+    });
+  };
+  auto hits = lookups(keys, 4 * n_keys, n_keys - 1);
+  auto miss = lookups(misses, 4 * n_keys, n_keys - 1);
+  auto hot = lookups(keys, n_keys, 1023);
+  auto iterate = bench::best_ms(5, [&] {
+    uint64_t sum = 0;
+    for (int pass = 0; pass < 4; pass++)
+      for (auto& entry : map)
+        sum += entry.second;
+    bench::keep(sum);
+  });
+
+  auto erase = best_ms_on(build, [&](Map& map) {
+    for (auto key : keys)
+      map.erase(key);
+  });
+
+  printf("%-20s %8.1f %8.1f %8.1f %8.1f %8.1f %8.1f\n", name, insert, hits, miss, iterate, erase,
+         hot);
+}
+
+int main() {
+  auto rng = pine::RNG(1);
+  auto keys = psl::vector<uint64_t>(n_keys);
+  auto misses = psl::vector<uint64_t>(n_keys);
+  for (auto& key : keys)
+    key = rng.next64u();
+  for (auto& key : misses)
+    key = rng.next64u();
+
+  printf("%-20s %8s %8s %8s %8s %8s %8s   (ms)\n", "", "insert", "4M hit", "4M miss", "iterate",
+         "erase", "1k hot");
+  run<psl::unordered_map<uint64_t, int>>("psl::unordered_map", keys, misses);
+  run<psl::flat_hash_map<uint64_t, int>>("psl::flat_hash_map", keys, misses);
+}
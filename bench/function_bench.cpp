@@ -0,0 +1,79 @@
+#include "bench.h"
+
+#include <psl/function.h>
+#include <psl/vector.h>
+
+#include <functional>
+#include <cstdio>
+
+// psl::function against the implementation it replaced and against std::function, all holding a
+// lambda that captures two ints: building 1M into a reserved vector, calling 10M times over 256
+// objects that stay in cache, and copying 1M
+
+// psl::function before it stored callables inline: every callable is moved into a shared
+// `FunctionModel` and called through its vtable, and copies share the model
+template <typename T>
+class SharedModelFunction;
+template <typename R, typename... Args>
+class SharedModelFunction<R(Args...)> {
+  struct FunctionConcept {
+    virtual ~FunctionConcept() = default;
+    virtual R call(Args... args) const = 0;
+  };
+  template <typename F>
+  struct FunctionModel : FunctionConcept {
+    FunctionModel(F f) : f(psl::move(f)) {}
+    R call(Args... args) const override {
+      return f(static_cast<Args>(args)...);
+    }
+    F f;
+  };
+  psl::shared_ptr<const FunctionConcept> model;
+
+public:
+  SharedModelFunction() = default;
+  template <typename F>
+  SharedModelFunction(F f) : model(psl::make_shared<FunctionModel<F>>(MOVE(f))) {}
+  R operator()(Args... args) const {
+    return model->call(static_cast<Args>(args)...);
+  }
+};
+
+template <typename Function>
+void run(const char* name) {
+  constexpr int n = 1 << 20;
+  auto construct = bench::best_ms(5, [] {
+    auto fs = psl::vector<Function>();
+    fs.reserve(n);
+    for (int i = 0; i < n; i++)
+      fs.push_back([a = i, b = i * 3](int x) { return a * x + b; });
+    bench::keep(fs);
+  });
+
+  auto hot = psl::vector<Function>();
+  for (int i = 0; i < 256; i++)
+    hot.push_back([a = i, b = i * 3](int x) { return a * x + b; });
+  auto invoke = bench::best_ms(5, [&] {
+    auto sum = 0;
+    for (int i = 0; i < 10 * n; i++)
+      sum += hot[i & 255](i);
+    bench::keep(sum);
+  });
+
+  auto fs = psl::vector<Function>();
+  for (int i = 0; i < n; i++)
+    fs.push_back([a = i, b = i * 3](int x) { return a * x + b; });
+  auto copy = bench::best_ms(5, [&] {
+    auto copies = fs;
+    bench::keep(copies);
+  });
+
+  printf("%-22s %3zu B   construct 1M %6.1f ms   invoke 10M %6.1f ms   copy 1M %6.1f ms\n", name,
+         sizeof(Function), construct, invoke, copy);
+}
+
+int main() {
+  run<SharedModelFunction<int(int)>>("shared FunctionModel");
+  run<psl::function<int(int)>>("psl::function");
+  run<std::function<int(int)>>("std::function");
+}
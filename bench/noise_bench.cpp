@@ -0,0 +1,79 @@
+#include "bench.h"
+
+#include <pine/noise.h>
+#include <pine/rng.h>
+
+#include <psl/vector.h>
+
+#include <cstdio>
+
+using namespace pine;
+
+// Per-sample cost of Perlin and simplex noise in 2D, 3D and 4D over 2^20 random points: the
+// scalar overloads, the batch overloads, and batch fbm of 8 octaves
+
+constexpr int n = 1 << 20;
+
+template <typename V>
+psl::vector<V> random_points(RNG& rng) {
+  constexpr int D = sizeof(V) / sizeof(float);
+  auto points = psl::vector<V>(n);
+  for (auto& p : points)
+    for (int i = 0; i < D; i++)
+      p[i] = rng.nextf() * 256.0f;
+  return points;
+}
+
+// Nanoseconds per point of `f` over all of `points`, best of 5
+template <typename F>
+double ns_per_point(F f) {
+  return bench::best_ms(5, f) * 1e6 / n;
+}
+
+template <typename V>
+double scalar_ns(const psl::vector<V>& points, psl::vector<float>& results, auto noise) {
+  return ns_per_point([&] {
+    for (int i = 0; i < n; i++)
+      results[i] = noise(points[i]);
+    bench::keep(results);
+  });
+}
+
+int main() {
+  auto rng = RNG(1);
+  auto p2 = random_points<vec2>(rng);
+  auto p3 = random_points<vec3>(rng);
+  auto p4 = random_points<vec4>(rng);
+  auto results = psl::vector<float>(n);
+  auto fbm8 = FbmParams();
+
+  auto batch = [&](auto noise) {
+    return ns_per_point([&] {
+      noise();
+      bench::keep(results);
+    });
+  };
+  auto row = [](const char* name, double d2, double d3, double d4) {
+    printf("%-16s %7.1f %7.1f ", name, d2, d3);
+    if (d4 < 0)
+      printf("%7s\n", "-");
+    else
+      printf("%7.1f\n", d4);
+  };
+
+  printf("%-16s %7s %7s %7s   (ns per point)\n", "", "2D", "3D", "4D");
+  row("perlin scalar", scalar_ns(p2, results, [](vec2 p) { return perlin_noise(p); }),
+      scalar_ns(p3, results, [](vec3 p) { return perlin_noise(p); }), -1);
+  row("simplex scalar", scalar_ns(p2, results, [](vec2 p) { return simplex_noise(p); }),
+      scalar_ns(p3, results, [](vec3 p) { return simplex_noise(p); }),
+      scalar_ns(p4, results, [](vec4 p) { return simplex_noise(p); }));
+  row("perlin batch", batch([&] { perlin_noise(p2, results); }),
+      batch([&] { perlin_noise(p3, results); }), -1);
+  row("simplex batch", batch([&] { simplex_noise(p2, results); }),
+      batch([&] { simplex_noise(p3, results); }), batch([&] { simplex_noise(p4, results); }));
+  row("perlin fbm8", batch([&] { fbm(p2, results, fbm8); }), batch([&] { fbm(p3, results, fbm8); }),
+      -1);
+  row("simplex fbm8", batch([&] { simplex_fbm(p2, results, fbm8); }),
+      batch([&] { simplex_fbm(p3, results, fbm8); }),
+      batch([&] { simplex_fbm(p4, results, fbm8); }));
+}
@@ -0,0 +1,46 @@
+#include "bench.h"
+
+#include <pine/parallel.h>
+#include <pine/noise.h>
+
+#include <psl/vector.h>
+
+#include <cstdio>
+
+using namespace pine;
+
+// Scheduling overhead of the job system, from 100k empty jobs, and a 512x512 image of 8-octave
+// fbm computed per pixel against the serial loop, for a range of thread counts
+
+constexpr int n_jobs = 100000;
+constexpr int size = 512;
+
+void shade(psl::vector<float>& image, int64_t first, int64_t last) {
+  for (auto y = first; y < last; y++)
+    for (int x = 0; x < size; x++)
+      image[y * size + x] = fbm(vec2(x, y) / 64.0f, 8);
+}
+
+int main() {
+  auto image = psl::vector<float>(size * size);
+  auto serial = bench::best_ms(3, [&] { shade(image, 0, size); });
+  printf("serial fbm  %7.1f ms\n", serial);
+
+  printf("%-8s %14s %14s %10s\n", "threads", "empty job", "fbm", "speedup");
+  for (int n_threads : {1, 2, 4, 8}) {
+    auto jobs = JobSystem(n_threads);
+    auto empty = bench::best_ms(5, [&] {
+      auto counter = JobCounter();
+      for (int i = 0; i < n_jobs; i++)
+        jobs.run([] {}, &counter);
+      jobs.wait(counter);
+    });
+    auto parallel = bench::best_ms(3, [&] {
+      jobs.parallel_chunks(0, size, 0, [&](int64_t first, int64_t last) {
+        shade(image, first, last);
+      });
+    });
+    printf("%-8d %11.1f ns %11.1f ms %9.2fx\n", n_threads, empty * 1e6 / n_jobs, parallel,
+           serial / parallel);
+  }
+}
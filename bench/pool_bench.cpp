@@ -0,0 +1,50 @@
+#include "bench.h"
+
+#include <pine/rng.h>
+
+#include <psl/pool.h>
+#include <psl/vector.h>
+
+#include <cstdio>
+
+// 1M allocations of 8-128 B churned through a live set of 4096 slots: each one frees whatever a
+// random slot holds and puts a new block there, as a long-running program's small objects do
+
+constexpr int n_ops = 1 << 20;
+constexpr int n_live = 4096;
+
+struct Op {
+  int slot;
+  int size;
+};
+
+template <typename Alloc, typename Free>
+double churn(const psl::vector<Op>& ops, Alloc alloc, Free free) {
+  return bench::best_ms(5, [&] {
+    auto live = psl::vector<void*>(n_live);
+    for (auto op : ops) {
+      if (live[op.slot])
+        free(live[op.slot]);
+      live[op.slot] = alloc(op.size);
+      *(char*)live[op.slot] = 1;
+    }
+    for (auto ptr : live)
+      if (ptr)
+        free(ptr);
+  });
+}
+
+int main() {
+  auto rng = pine::RNG(1);
+  auto ops = psl::vector<Op>(n_ops);
+  for (auto& op : ops)
+    op = {int(rng.next32u(n_live)), 8 + int(rng.next32u(121))};
+
+  auto private_pool = psl::pool_resource();
+  printf("new/delete    %6.1f ms\n",
+         churn(ops, [](int size) { return (void*)new char[size]; },
+               [](void* ptr) { delete[] (char*)ptr; }));
+  printf("pool_alloc    %6.1f ms\n", churn(ops, psl::pool_alloc, psl::pool_free));
+  printf("private pool  %6.1f ms\n",
+         churn(ops, [&](int size) { return private_pool.alloc(size); }, psl::pool_resource::free));
+}
@@ -0,0 +1,48 @@
+#include "bench.h"
+
+#include <pine/rng.h>
+
+#include <psl/algorithm.h>
+#include <psl/vector.h>
+
+#include <algorithm>
+#include <cstdio>
+
+// psl::sort and psl::stable_sort against std::sort on 1M ints that are random, already sorted,
+// reversed, and drawn from 16 distinct values
+
+constexpr int n = 1 << 20;
+
+// The best of 5 timings of `sort` on fresh copies of `input`
+template <typename F>
+double sort_ms(const psl::vector<int>& input, F sort) {
+  auto best = 1e30;
+  for (int run = 0; run < 5; run++) {
+    auto v = input;
+    auto ms = bench::best_ms(1, [&] { sort(v); });
+    best = ms < best ? ms : best;
+  }
+  return best;
+}
+
+int main() {
+  auto rng = pine::RNG(1);
+  auto random = psl::vector<int>(n), sorted = psl::vector<int>(n);
+  auto reversed = psl::vector<int>(n), few_unique = psl::vector<int>(n);
+  for (int i = 0; i < n; i++) {
+    random[i] = int(rng.next32u());
+    sorted[i] = i;
+    reversed[i] = n - i;
+    few_unique[i] = int(rng.next32u(16));
+  }
+
+  printf("%-12s %10s %10s %10s   (ms)\n", "", "psl::sort", "std::sort", "stable");
+  for (auto [name, input] : {psl::pair<const char*, const psl::vector<int>*>{"random", &random},
+                             {"sorted", &sorted},
+                             {"reversed", &reversed},
+                             {"few-unique", &few_unique}})
+    printf("%-12s %10.1f %10.1f %10.1f\n", name,
+           sort_ms(*input, [](auto& v) { psl::sort(v); }),
+           sort_ms(*input, [](auto& v) { std::sort(v.begin(), v.end()); }),
+           sort_ms(*input, [](auto& v) { psl::stable_sort(v); }));
+}
@@ -0,0 +1,83 @@
+#include "bench.h"
+
+#include <pine/vecmath.h>
+
+#include <psl/string.h>
+#include <psl/vector.h>
+
+#include <cstdio>
+#include <new>
+
+using namespace pine;
+
+// push_back throughput of psl::vector for vec3, psl::string and a struct laid out like main.cpp's
+// Model, against the growth path it replaced, which copied every element's bytes one at a time
+// into the new buffer whatever its type
+
+// Position and color, then the vector of triangle fans
+struct ModelLike {
+  vec3 position;
+  vec3 color;
+  psl::vector<int> fans;
+};
+
+// A vector that grows the way psl::vector did before it relocated its elements
+template <typename T>
+class ByteCopyVector {
+public:
+  ByteCopyVector() = default;
+  ~ByteCopyVector() {
+    for (size_t i = 0; i < len; i++)
+      ptr[i].~T();
+    ::operator delete(ptr);
+  }
+  ByteCopyVector(const ByteCopyVector&) = delete;
+  ByteCopyVector& operator=(const ByteCopyVector&) = delete;
+
+  void push_back(T x) {
+    if (len == reserved) {
+      auto nreserved = reserved ? reserved * 2 : 1;
+      auto nptr = static_cast<T*>(::operator new(nreserved * sizeof(T)));
+      auto src = reinterpret_cast<const char*>(ptr);
+      auto dst = reinterpret_cast<char*>(nptr);
+      for (size_t i = 0; i < len * sizeof(T); i++)
+        dst[i] = src[i];
+      ::operator delete(ptr);
+      ptr = nptr;
+      reserved = nreserved;
+    }
+    new (ptr + len++) T(static_cast<T&&>(x));
+  }
+
+private:
+  T* ptr = nullptr;
+  size_t len = 0;
+  size_t reserved = 0;
+};
+
+// Push `n` elements made by `make` onto a fresh `Vector`, best of 5
+template <typename Vector, typename F>
+double push_back_ms(int n, F make) {
+  return bench::best_ms(5, [&] {
+    auto v = Vector();
+    for (int i = 0; i < n; i++)
+      v.push_back(make(i));
+    bench::keep(v);
+  });
+}
+
+template <typename T, typename F>
+void run(const char* name, int n, F make) {
+  printf("%-20s %12.1f %12.1f\n", name, push_back_ms<ByteCopyVector<T>>(n, make),
+         push_back_ms<psl::vector<T>>(n, make));
+}
+
+int main() {
+  printf("%-20s %12s %12s   (ms)\n", "", "byte copy", "psl::vector");
+  run<vec3>("vec3 (1M)", 1 << 20, [](int i) { return vec3(i, i + 1, i + 2); });
+  run<psl::string>("psl::string (256k)", 1 << 18,
+                   [](int) { return psl::string("sixteen chars..."); });
+  run<ModelLike>("Model-like (256k)", 1 << 18, [](int i) {
+    return ModelLike{vec3(i), vec3(1.0f), psl::vector<int>(4)};
+  });
+}
@@ -3,6 +3,7 @@
 #include <glad/glad.h>
 
 #include <psl/fstream.h>
+#include <psl/colony.h>
 
 #include <pine/vecmath.h>
 #include <pine/fileio.h>
@@ -235,13 +236,15 @@ Mesh create_circle(vec2 center, float radius, int segments) {
 }
 
 struct Scene {
-  void add(Model model) { models.push_back(MOVE(model)); }
+  // The returned reference stays valid until the model is removed
+  Model& add(Model model) { return models.insert(MOVE(model)); }
+  void remove(Model& model) { models.erase(&model); }
   void draw(const GLProgram& program) const {
     for (const auto& model : models) model.draw(program);
   }
 
  private:
-  psl::vector<Model> models;
+  psl::colony<Model> models;
 };
 
 vec3 pos = vec3(0, 0, -1);
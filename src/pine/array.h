@@ -1,5 +1,6 @@
 #pragma once
 #include <pine/vecmath.h>
+#include <pine/parallel.h>
 #include <pine/log.h>
 
 namespace pine {
@@ -14,38 +15,25 @@ struct Array2d {
   }
   template <typename U>
   static Array2d from(const Array2d<U> &rhs, bool invert_y = false) {
+    return from(execution::seq, rhs, invert_y);
+  }
+  // With `execution::par`, bands of rows are converted on the job system
+  template <ExecutionPolicy Policy, typename U>
+  static Array2d from(Policy, const Array2d<U> &rhs, bool invert_y = false) {
     auto result = Array2d(rhs.size());
-    for_2d(rhs.size(), [&](vec2i p) {
-      auto x = invert_y ? rhs[{p.x, rhs.size().y - 1 - p.y}] : rhs[p];
-      if constexpr (psl::same_as<T, U>)
-        result[p] = x;
-      else if constexpr (psl::same_as<T, vec4> && psl::same_as<U, vec3>)
-        result[p] = vec4(x, 1.0f);
-      else if constexpr (psl::same_as<T, vec4> && psl::same_as<U, vec3u8>)
-        result[p] = vec4(x / 256.0f, 1.0f);
-      else if constexpr (psl::same_as<T, vec4> && psl::same_as<U, vec4u8>)
-        result[p] = vec4(x / 256.0f);
-      else if constexpr (psl::same_as<T, vec3> && psl::same_as<U, vec4>)
-        result[p] = vec3(x);
-      else if constexpr (psl::same_as<T, vec3> && psl::same_as<U, vec4u8>)
-        result[p] = vec3(x / 256.0f);
-      else if constexpr (psl::same_as<T, vec3> && psl::same_as<U, vec3u8>)
-        result[p] = vec3(x / 256.0f);
-      else if constexpr (psl::same_as<T, vec4u8> && psl::same_as<U, vec3u8>)
-        result[p] = vec4u8(x, uint8_t(255));
-      else if constexpr (psl::same_as<T, vec4u8> && psl::same_as<U, vec4>)
-        result[p] = vec4u8((vec3u8)min(pow(x, 1 / 2.2f) * 256, vec4(255)), uint8_t(255));
-      else if constexpr (psl::same_as<T, vec4u8> && psl::same_as<U, vec3>)
-        result[p] = vec4u8((vec3u8)min(pow(x, 1 / 2.2f) * 256, vec3(255)), uint8_t(255));
-      else if constexpr (psl::same_as<T, vec3u8> && psl::same_as<U, vec4u8>)
-        result[p] = vec3u8(x);
-      else if constexpr (psl::same_as<T, vec3u8> && psl::same_as<U, vec4>)
-        result[p] = vec3u8(min(pow(x, 1 / 2.2f) * 256, vec4(255)));
-      else if constexpr (psl::same_as<T, vec3u8> && psl::same_as<U, vec3>)
-        result[p] = vec3u8(min(pow(x, 1 / 2.2f) * 256, vec3(255)));
-      else
-        static_assert(psl::deferred_bool<false, U>, "not supported");
-    });
+    auto width = rhs.width(), height = rhs.height();
+    auto convert_rows = [&](int64_t first, int64_t last) {
+      for (auto y = int(first); y < int(last); y++) {
+        auto src = rhs.data() + size_t(invert_y ? height - 1 - y : y) * width;
+        auto dst = result.data() + size_t(y) * width;
+        for (int x = 0; x < width; x++)
+          dst[x] = convert<U>(src[x]);
+      }
+    };
+    if constexpr (psl::same_as<Policy, execution::Parallel>)
+      parallel_chunks(0, height, psl::max(pixels_per_task / psl::max(width, 1), 1), convert_rows);
+    else
+      convert_rows(0, height);
     return result;
   }
 
@@ -173,6 +161,41 @@ struct Array2d {
   }
 
 private:
+  // Enough work per task to amortize scheduling it, and few enough rows to balance the load
+  static constexpr int pixels_per_task = 1 << 14;
+
+  template <typename U>
+  static T convert(U x) {
+    if constexpr (psl::same_as<T, U>)
+      return x;
+    else if constexpr (psl::same_as<T, vec4> && psl::same_as<U, vec3>)
+      return vec4(x, 1.0f);
+    else if constexpr (psl::same_as<T, vec4> && psl::same_as<U, vec3u8>)
+      return vec4(x / 256.0f, 1.0f);
+    else if constexpr (psl::same_as<T, vec4> && psl::same_as<U, vec4u8>)
+      return vec4(x / 256.0f);
+    else if constexpr (psl::same_as<T, vec3> && psl::same_as<U, vec4>)
+      return vec3(x);
+    else if constexpr (psl::same_as<T, vec3> && psl::same_as<U, vec4u8>)
+      return vec3(x / 256.0f);
+    else if constexpr (psl::same_as<T, vec3> && psl::same_as<U, vec3u8>)
+      return vec3(x / 256.0f);
+    else if constexpr (psl::same_as<T, vec4u8> && psl::same_as<U, vec3u8>)
+      return vec4u8(x, uint8_t(255));
+    else if constexpr (psl::same_as<T, vec4u8> && psl::same_as<U, vec4>)
+      return vec4u8(gamma_encode_u8(vec3(x)), uint8_t(255));
+    else if constexpr (psl::same_as<T, vec4u8> && psl::same_as<U, vec3>)
+      return vec4u8(gamma_encode_u8(x), uint8_t(255));
+    else if constexpr (psl::same_as<T, vec3u8> && psl::same_as<U, vec4u8>)
+      return vec3u8(x);
+    else if constexpr (psl::same_as<T, vec3u8> && psl::same_as<U, vec4>)
+      return gamma_encode_u8(vec3(x));
+    else if constexpr (psl::same_as<T, vec3u8> && psl::same_as<U, vec3>)
+      return gamma_encode_u8(x);
+    else
+      static_assert(psl::deferred_bool<false, U>, "not supported");
+  }
+
   vec2i size_;
   psl::vector<T> data_;
 };
@@ -281,6 +304,7 @@ using Array2d3f = Array2d<vec3>;
 using Array2d4f = Array2d<vec4>;
 using Array2d3u8 = Array2d<vec3u8>;
 using Array2d4u8 = Array2d<vec4u8>;
+using Array3df = Array3d<float>;
 
 template <typename F>
 void for_2d(vec2i lower, vec2i upper, F f) {
@@ -328,6 +352,7 @@ Array2d<T> combine(Array2d<T> a, const Array2d<T> &b, float weight_a, float weig
   return a;
 }
 
+struct Context;
 void array2d_context(Context &context);
 
 }  // namespace pine
\ No newline at end of file
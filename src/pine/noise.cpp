@@ -1,6 +1,13 @@
 #include <pine/sampling.h>
 #include <pine/noise.h>
 #include <pine/rng.h>
+#include <pine/rng_avx2.h>
+#include <pine/log.h>
+
+#include <psl/flat_hash_map.h>
+#include <psl/vector.h>
+#include <psl/thread.h>
+#include <psl/cpu.h>
 
 namespace pine {
 
@@ -40,6 +47,155 @@ float perlin_noise(vec3 np, int seed) {
   return 0.5f * (1.0f + perlin_interp(noise, w));
 }
 
+namespace {
+
+// The gradients of one seed for `PerlinGradients::Table`, drawn from the same distributions as the
+// hashed ones. `perm` holds a permutation of 0-255 twice over, so that chained lookups don't wrap;
+// gradients are stored by component so that the batch kernels can gather them
+struct PerlinTable {
+  static constexpr int size = 256;
+
+  explicit PerlinTable(int seed) {
+    auto rng = RNG(uint64_t(uint32_t(seed)));
+    for (int i = 0; i < size; i++)
+      perm[i] = i;
+    for (int i = size - 1; i > 0; i--)
+      psl::swap(perm[i], perm[rng.next32u(i + 1)]);
+    for (int i = 0; i < size; i++) {
+      perm[size + i] = perm[i];
+      auto g2 = sample_disk_concentric(rng.next2f());
+      auto u = rng.next2f();
+      auto g3 = spherical_to_cartesian(u.x * Pi * 2, u.y * Pi);
+      for (int k = 0; k < 2; k++)
+        this->g2[k][i] = g2[k];
+      for (int k = 0; k < 3; k++)
+        this->g3[k][i] = g3[k];
+    }
+  }
+
+  int corner(int x, int y) const {
+    return perm[perm[x & (size - 1)] + (y & (size - 1))];
+  }
+  int corner(int x, int y, int z) const {
+    return perm[perm[perm[x & (size - 1)] + (y & (size - 1))] + (z & (size - 1))];
+  }
+
+  int32_t perm[size * 2];
+  float g2[2][size];
+  float g3[3][size];
+};
+
+// Tables are built on the first use of their seed and kept until exit. The first `capacity` seeds
+// go in an insert-only hash table that is searched without locking; once it is full, further
+// seeds go in a growable map behind a lock, so a program that goes through many seeds pays for
+// the lock rather than failing
+class PerlinTables {
+public:
+  ~PerlinTables() {
+    for (auto &table : tables)
+      delete table.load(psl::memory_order::relaxed);
+  }
+
+  const PerlinTable &operator()(int seed) {
+    auto key = uint64_t(uint32_t(seed)) + 1;
+    auto i = size_t(mix_bits(key));
+    for (size_t probe = 0; probe < capacity; probe++, i++) {
+      i &= capacity - 1;
+      auto k = keys[i].load(psl::memory_order::acquire);
+      if (k == 0 && keys[i].compare_exchange_strong(k, key)) {
+        auto table = new PerlinTable(seed);
+        tables[i].store(table, psl::memory_order::release);
+        return *table;
+      }
+      if (k == key) {
+        // The thread that claimed the slot may still be building the table
+        auto table = tables[i].load(psl::memory_order::acquire);
+        for (; !table; table = tables[i].load(psl::memory_order::acquire))
+          psl::cpu_relax();
+        return *table;
+      }
+    }
+    return overflow_table(seed);
+  }
+
+private:
+  static constexpr size_t capacity = 1024;
+
+  // Tables are built outside the lock, and a thread that loses the race to insert its table
+  // drops it; the map only holds pointers, so the references handed out stay valid as it grows
+  const PerlinTable &overflow_table(int seed) {
+    lock();
+    auto it = overflow.find(seed);
+    auto found = it != overflow.end() ? it->second.get() : nullptr;
+    unlock();
+    if (found)
+      return *found;
+
+    auto table = psl::make_unique<PerlinTable>(seed);
+    lock();
+    auto &slot = overflow[seed];
+    if (!slot)
+      slot = psl::move(table);
+    found = slot.get();
+    unlock();
+    return *found;
+  }
+
+  void lock() {
+    while (locked.exchange(true, psl::memory_order::acquire))
+      psl::cpu_relax();
+  }
+  void unlock() {
+    locked.store(false, psl::memory_order::release);
+  }
+
+  psl::atomic<uint64_t> keys[capacity] = {};
+  psl::atomic<PerlinTable *> tables[capacity] = {};
+  psl::flat_hash_map<int, psl::unique_ptr<PerlinTable>> overflow;
+  psl::atomic<bool> locked = false;
+};
+
+const PerlinTable &perlin_table(int seed) {
+  static PerlinTables tables;
+  return tables(seed);
+}
+
+}  // namespace
+
+float perlin_noise(vec2 np, int seed, PerlinGradients gradients) {
+  if (gradients == PerlinGradients::Hashed)
+    return perlin_noise(np, seed);
+  auto &table = perlin_table(seed);
+  auto cell = floor(np);
+  auto w = np - cell;
+  w = w * w * (vec2(3) - 2 * w);
+
+  vec2 noise[2][2];
+  for (int x = 0; x < 2; x++)
+    for (int y = 0; y < 2; y++) {
+      auto i = table.corner(int(cell.x) + x, int(cell.y) + y);
+      noise[x][y] = vec2(table.g2[0][i], table.g2[1][i]);
+    }
+  return 0.5f * (1.0f + perlin_interp(noise, w));
+}
+float perlin_noise(vec3 np, int seed, PerlinGradients gradients) {
+  if (gradients == PerlinGradients::Hashed)
+    return perlin_noise(np, seed);
+  auto &table = perlin_table(seed);
+  auto cell = floor(np);
+  auto w = np - cell;
+  w = w * w * (vec3(3) - 2 * w);
+
+  vec3 noise[2][2][2];
+  for (int x = 0; x < 2; x++)
+    for (int y = 0; y < 2; y++)
+      for (int z = 0; z < 2; z++) {
+        auto i = table.corner(int(cell.x) + x, int(cell.y) + y, int(cell.z) + z);
+        noise[x][y][z] = vec3(table.g3[0][i], table.g3[1][i], table.g3[2][i]);
+      }
+  return 0.5f * (1.0f + perlin_interp(noise, w));
+}
+
 vec2 perlin_noise2d(float np, int seed) {
   return {perlin_noise(np, seed), perlin_noise(np, seed + 1)};
 }
@@ -60,6 +216,1008 @@ vec3 perlin_noise3d(vec3 np, int seed) {
   return {perlin_noise(np, seed), perlin_noise(np, seed + 1), perlin_noise(np, seed + 2)};
 }
 
+namespace {
+
+// Skew factors, kernel radius and normalization of D-dimensional simplex noise. The simplex
+// containing a point is found by skewing space so that simplices become the halves, sixths or
+// 24ths of unit cubes, and ordering the offsets from the cube's origin; `scale` brings the
+// largest sum of corner contributions to 1
+template <int D>
+struct SimplexLattice;
+template <>
+struct SimplexLattice<2> {
+  static constexpr float skew = 0.36602540378f;    // (sqrt(3) - 1) / 2
+  static constexpr float unskew = 0.21132486540f;  // (3 - sqrt(3)) / 6
+  static constexpr float radius2 = 0.5f;
+  static constexpr float scale = 99.41f;
+  static constexpr int gradient_bits = 4;
+};
+template <>
+struct SimplexLattice<3> {
+  static constexpr float skew = 1.0f / 3.0f;
+  static constexpr float unskew = 1.0f / 6.0f;
+  static constexpr float radius2 = 0.6f;
+  static constexpr float scale = 32.69f;
+  static constexpr int gradient_bits = 4;
+};
+template <>
+struct SimplexLattice<4> {
+  static constexpr float skew = 0.30901699437f;    // (sqrt(5) - 1) / 4
+  static constexpr float unskew = 0.13819660113f;  // (5 - sqrt(5)) / 20
+  static constexpr float radius2 = 0.6f;
+  static constexpr float scale = 27.22f;
+  static constexpr int gradient_bits = 5;
+};
+
+// The gradient sets of simplex noise, stored by component so that the batch kernels can gather
+// them: 16 unit vectors in 2D, the 12 cube edges in 3D with 4 of them repeated to make 16, and
+// the 32 edges of the 4D hypercube
+struct SimplexGradients {
+  SimplexGradients() {
+    for (int i = 0; i < 16; i++) {
+      auto phi = (i + 0.5f) * Pi / 8;
+      g2[0][i] = psl::cos(phi);
+      g2[1][i] = psl::sin(phi);
+    }
+    constexpr int8_t edges[16][3] = {{1, 1, 0},  {-1, 1, 0},  {1, -1, 0}, {-1, -1, 0},
+                                     {1, 0, 1},  {-1, 0, 1},  {1, 0, -1}, {-1, 0, -1},
+                                     {0, 1, 1},  {0, -1, 1},  {0, 1, -1}, {0, -1, -1},
+                                     {1, 1, 0},  {-1, 1, 0},  {0, -1, 1}, {0, -1, -1}};
+    for (int i = 0; i < 16; i++)
+      for (int a = 0; a < 3; a++)
+        g3[a][i] = edges[i][a];
+    for (int i = 0; i < 32; i++) {
+      auto zero_axis = i / 8;
+      for (int a = 0, bit = 0; a < 4; a++)
+        g4[a][i] = a == zero_axis ? 0.0f : ((i >> bit++) & 1) ? -1.0f : 1.0f;
+    }
+  }
+
+  float g2[2][16];
+  float g3[3][16];
+  float g4[4][32];
+};
+const SimplexGradients simplex_gradients;
+
+template <int D>
+const float *simplex_gradient(int axis) {
+  if constexpr (D == 2)
+    return simplex_gradients.g2[axis];
+  else if constexpr (D == 3)
+    return simplex_gradients.g3[axis];
+  else
+    return simplex_gradients.g4[axis];
+}
+
+// Hash of a lattice point and seed selecting its gradient. It only uses 32-bit multiplies and
+// shifts, so the batch kernels reproduce it exactly
+template <int D>
+uint32_t simplex_hash(const int *corner, int seed) {
+  auto h = uint32_t(seed) * 0x9e3779b9u;
+  for (int a = 0; a < D; a++) {
+    h = (h ^ uint32_t(corner[a])) * 0x85ebca6bu;
+    h ^= h >> 13;
+  }
+  h *= 0xc2b2ae35u;
+  return h ^ (h >> 16);
+}
+
+// The seed of channel c in the given octave
+int octave_seed(const FbmParams &params, int octave, int c) {
+  return params.seed + c + octave * params.octave_seed_step;
+}
+// The sum of the octaves' weights, which fbm divides by
+float octave_weight_total(const FbmParams &params) {
+  auto weight = 1.0f, total = 0.0f;
+  for (int octave = 0; octave < params.octaves; octave++) {
+    total += weight;
+    weight *= params.gain;
+  }
+  return total;
+}
+bool has_warp(const FractalParams &params) {
+  return params.warp != 0.0f && params.warp_octaves.octaves > 0;
+}
+// What `fractal_noise` divides its sum by to bring it to [0, 1]
+float fractal_normalizer(const FractalParams &params) {
+  auto total = octave_weight_total(params.octaves);
+  return params.shape == FractalShape::Ridged ? total * psl::sqr(params.ridge_offset) : total;
+}
+
+// Simplex noise in [-1, 1]. Sorting the offsets from the skewed cell's origin gives the path
+// through the simplex: corner k is offset by 1 along the k axes with the largest offsets
+template <int D>
+float simplex_noise(const float *p, int seed) {
+  using Lattice = SimplexLattice<D>;
+  auto s = 0.0f;
+  for (int a = 0; a < D; a++)
+    s += p[a];
+  s *= Lattice::skew;
+  int cell[D];
+  auto t = 0.0f;
+  for (int a = 0; a < D; a++) {
+    cell[a] = int(psl::floor(p[a] + s));
+    t += float(cell[a]);
+  }
+  t *= Lattice::unskew;
+  float d0[D];
+  for (int a = 0; a < D; a++)
+    d0[a] = p[a] - (float(cell[a]) - t);
+
+  int rank[D] = {};
+  for (int a = 0; a < D; a++)
+    for (int b = a + 1; b < D; b++)
+      rank[d0[a] > d0[b] ? a : b]++;
+
+  auto sum = 0.0f;
+  for (int k = 0; k <= D; k++) {
+    int corner[D];
+    float d[D];
+    auto falloff = Lattice::radius2;
+    for (int a = 0; a < D; a++) {
+      auto o = rank[a] >= D - k ? 1 : 0;
+      corner[a] = cell[a] + o;
+      d[a] = d0[a] - float(o) + float(k) * Lattice::unskew;
+      falloff -= d[a] * d[a];
+    }
+    if (falloff <= 0.0f)
+      continue;
+    auto i = simplex_hash<D>(corner, seed) >> (32 - Lattice::gradient_bits);
+    auto dot = 0.0f;
+    for (int a = 0; a < D; a++)
+      dot += simplex_gradient<D>(a)[i] * d[a];
+    falloff *= falloff;
+    sum += falloff * falloff * dot;
+  }
+  return Lattice::scale * sum;
+}
+
+}  // namespace
+
+float simplex_noise(vec2 np, int seed) {
+  return 0.5f * (1.0f + simplex_noise<2>(&np[0], seed));
+}
+float simplex_noise(vec3 np, int seed) {
+  return 0.5f * (1.0f + simplex_noise<3>(&np[0], seed));
+}
+float simplex_noise(vec4 np, int seed) {
+  return 0.5f * (1.0f + simplex_noise<4>(&np[0], seed));
+}
+
+#ifdef PSL_X86
+namespace {
+
+// The batch kernels evaluate 8 points per iteration, one per lane. Corner gradients are hashed
+// exactly like the scalar path, with the 64-bit arithmetic split over two registers of 4 lanes,
+// so only the trigonometry, done with polynomials here, differs in the last bits
+constexpr uint64_t murmur_m = 0xc6a4a7935bd1e995ull;
+
+PSL_AVX2 inline __m256i mul64(__m256i a, uint64_t b) {
+  auto b_lo = _mm256_set1_epi64x(int64_t(b & 0xffffffff));
+  auto b_hi = _mm256_set1_epi64x(int64_t(b >> 32));
+  auto cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(a, 32), b_lo),
+                                _mm256_mul_epu32(a, b_hi));
+  return _mm256_add_epi64(_mm256_mul_epu32(a, b_lo), _mm256_slli_epi64(cross, 32));
+}
+template <int shift>
+PSL_AVX2 inline __m256i xor_shift(__m256i x) {
+  return _mm256_xor_si256(x, _mm256_srli_epi64(x, shift));
+}
+// Two 32-bit values per 64-bit lane, `lo` in the low half, as `hash` lays out its arguments
+PSL_AVX2 inline __m256i pack64(__m128i lo, __m128i hi) {
+  return _mm256_or_si256(_mm256_cvtepu32_epi64(lo),
+                         _mm256_slli_epi64(_mm256_cvtepu32_epi64(hi), 32));
+}
+
+PSL_AVX2 inline __m256i murmur_word(__m256i h, __m256i k) {
+  k = mul64(k, murmur_m);
+  k = xor_shift<47>(k);
+  k = mul64(k, murmur_m);
+  return mul64(_mm256_xor_si256(h, k), murmur_m);
+}
+PSL_AVX2 inline __m256i murmur_finish(__m256i h) {
+  return xor_shift<47>(mul64(xor_shift<47>(h), murmur_m));
+}
+// `hash(vec2i(x, y), seed)` and `hash(vec3i(x, y, z), seed)` hash 12 and 16 bytes whose first
+// word holds x and y, so the state after it is shared by every seed
+PSL_AVX2 inline __m256i hash_prefix(__m128i x, __m128i y, int dim) {
+  return murmur_word(_mm256_set1_epi64x(int64_t((dim == 2 ? 12 : 16) * murmur_m)), pack64(x, y));
+}
+// The rest of `hash(vec2i(x, y), seed)`: a 4-byte tail
+PSL_AVX2 inline __m256i hash_finish(__m256i prefix, int seed) {
+  auto h = _mm256_xor_si256(prefix, _mm256_set1_epi64x(uint32_t(seed)));
+  return murmur_finish(mul64(h, murmur_m));
+}
+// The rest of `hash(vec3i(x, y, z), seed)`: the word holding z and the seed
+PSL_AVX2 inline __m256i hash_finish(__m256i prefix, __m128i z, int seed) {
+  return murmur_finish(murmur_word(prefix, pack64(z, _mm_set1_epi32(seed))));
+}
+PSL_AVX2 inline __m128i half128(__m256i x, int half) {
+  return half ? _mm256_extracti128_si256(x, 1) : _mm256_castsi256_si128(x);
+}
+
+PSL_AVX2 inline __m256i split_mix_64(__m256i s) {
+  s = mul64(xor_shift<30>(s), 0xBF58476D1CE4E5B9ULL);
+  s = mul64(xor_shift<27>(s), 0x94D049BB133111EBULL);
+  return xor_shift<31>(s);
+}
+// `RNG{h}.next2f()` before the conversion to float
+PSL_AVX2 inline void rng_next2u(__m256i h, __m128i& u0, __m128i& u1) {
+  auto golden = _mm256_set1_epi64x(int64_t(0x9E3779B97f4A7C15ULL));
+  auto s0 = split_mix_64(_mm256_add_epi64(h, golden));
+  auto s1 = split_mix_64(_mm256_add_epi64(h, _mm256_add_epi64(golden, golden)));
+  u0 = fold32(rng_next64u(s0, s1));
+  u1 = fold32(rng_next64u(s0, s1));
+}
+// Polynomial sine and cosine, accurate to a few ulps for the [-2pi, 2pi] the gradients need
+PSL_AVX2 inline void sincos(__m256 x, __m256 &sin, __m256 &cos) {
+  auto j = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(2 / Pi)),
+                           _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+  auto r = _mm256_fnmadd_ps(j, _mm256_set1_ps(1.5703125f), x);
+  r = _mm256_fnmadd_ps(j, _mm256_set1_ps(4.837512969970703125e-4f), r);
+  r = _mm256_fnmadd_ps(j, _mm256_set1_ps(7.54978995489188216e-8f), r);
+  auto r2 = _mm256_mul_ps(r, r);
+
+  auto ps = _mm256_set1_ps(-1.9515295891e-4f);
+  ps = _mm256_fmadd_ps(r2, ps, _mm256_set1_ps(8.3321608736e-3f));
+  ps = _mm256_fmadd_ps(r2, ps, _mm256_set1_ps(-1.6666654611e-1f));
+  ps = _mm256_fmadd_ps(_mm256_mul_ps(r2, r), ps, r);
+  auto pc = _mm256_set1_ps(2.443315711809948e-5f);
+  pc = _mm256_fmadd_ps(r2, pc, _mm256_set1_ps(-1.388731625493765e-3f));
+  pc = _mm256_fmadd_ps(r2, pc, _mm256_set1_ps(4.166664568298827e-2f));
+  auto one_minus_half_r2 = _mm256_fnmadd_ps(r2, _mm256_set1_ps(0.5f), _mm256_set1_ps(1.0f));
+  pc = _mm256_fmadd_ps(_mm256_mul_ps(r2, r2), pc, one_minus_half_r2);
+
+  // Quadrant q maps (sin, cos) of r to (sin, cos), (cos, -sin), (-sin, -cos), (-cos, sin)
+  auto q = _mm256_cvtps_epi32(j);
+  auto one = _mm256_set1_epi32(1), two = _mm256_set1_epi32(2);
+  auto swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(q, one), one));
+  auto sin_sign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(q, two), 30));
+  auto cos_sign = _mm256_castsi256_ps(
+      _mm256_slli_epi32(_mm256_and_si256(_mm256_add_epi32(q, one), two), 30));
+  sin = _mm256_xor_ps(_mm256_blendv_ps(ps, pc, swap), sin_sign);
+  cos = _mm256_xor_ps(_mm256_blendv_ps(pc, ps, swap), cos_sign);
+}
+
+// `x * x * (3 - 2 * x)` of the fractional part; `cell` gets the floor
+PSL_AVX2 inline __m256 fade(__m256 x, __m256 &cell) {
+  cell = _mm256_floor_ps(x);
+  auto w = _mm256_sub_ps(x, cell);
+  auto three_minus_2w = _mm256_fnmadd_ps(_mm256_set1_ps(2.0f), w, _mm256_set1_ps(3.0f));
+  return _mm256_mul_ps(_mm256_mul_ps(w, w), three_minus_2w);
+}
+// The interpolation weight of corner offset `o` along an axis, and `w - o`
+PSL_AVX2 inline __m256 corner_weight(__m256 w, int o) {
+  return o ? w : _mm256_sub_ps(_mm256_set1_ps(1.0f), w);
+}
+PSL_AVX2 inline __m256 corner_delta(__m256 w, int o) {
+  return _mm256_sub_ps(w, _mm256_set1_ps(float(o)));
+}
+PSL_AVX2 inline __m256i corner_coord(__m256 cell, int o) {
+  return _mm256_cvttps_epi32(_mm256_add_ps(cell, _mm256_set1_ps(float(o))));
+}
+
+// Gather up to 8 points into lanes, repeating the last one to fill the rest
+template <int N, typename V>
+void load_lanes(const V *points, size_t n, float (*lanes)[8]) {
+  for (size_t j = 0; j < 8; j++)
+    for (int k = 0; k < N; k++)
+      lanes[k][j] = points[psl::min(j, n - 1)][k];
+}
+
+// Corner gradients of the batch kernels for C seeds at once, 8 corners at a time:
+// `g[c][axis]` gets the gradient of seed c at the corners in `coords`
+template <int C>
+struct HashedGradients {
+  int seeds[C];
+
+  template <int D>
+  PSL_AVX2 void operator()(const __m256i *coords, __m256 (*g)[D]) const {
+    __m128i u[C][2][2];
+    for (int half = 0; half < 2; half++) {
+      auto prefix = hash_prefix(half128(coords[0], half), half128(coords[1], half), D);
+      for (int c = 0; c < C; c++) {
+        auto h = D == 2 ? hash_finish(prefix, seeds[c])
+                        : hash_finish(prefix, half128(coords[D - 1], half), seeds[c]);
+        rng_next2u(h, u[c][0][half], u[c][1][half]);
+      }
+    }
+    for (int c = 0; c < C; c++) {
+      auto ux = to_unit_float(_mm256_set_m128i(u[c][0][1], u[c][0][0]));
+      auto uy = to_unit_float(_mm256_set_m128i(u[c][1][1], u[c][1][0]));
+      if constexpr (D == 2)
+        sample_disk_concentric(ux, uy, g[c][0], g[c][1]);
+      else
+        spherical_to_cartesian(ux, uy, g[c][0], g[c][1], g[c][2]);
+    }
+  }
+
+  // `sample_disk_concentric(u)`
+  PSL_AVX2 static void sample_disk_concentric(__m256 ux, __m256 uy, __m256 &gx, __m256 &gy) {
+    auto one = _mm256_set1_ps(1.0f), two = _mm256_set1_ps(2.0f);
+    ux = _mm256_fmsub_ps(ux, two, one);
+    uy = _mm256_fmsub_ps(uy, two, one);
+    auto abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    auto x_major = _mm256_cmp_ps(_mm256_and_ps(ux, abs_mask), _mm256_and_ps(uy, abs_mask),
+                                 _CMP_GT_OQ);
+    auto r = _mm256_blendv_ps(uy, ux, x_major);
+    auto theta_x = _mm256_div_ps(_mm256_mul_ps(_mm256_set1_ps(Pi / 4.0f), uy), ux);
+    auto theta_y = _mm256_fnmadd_ps(_mm256_set1_ps(Pi / 4.0f), _mm256_div_ps(ux, uy),
+                                    _mm256_set1_ps(Pi / 2.0f));
+    __m256 sin, cos;
+    sincos(_mm256_blendv_ps(theta_y, theta_x, x_major), sin, cos);
+    gx = _mm256_mul_ps(r, cos);
+    gy = _mm256_mul_ps(r, sin);
+  }
+  // `spherical_to_cartesian(u.x * Pi * 2, u.y * Pi)`
+  PSL_AVX2 static void spherical_to_cartesian(__m256 ux, __m256 uy, __m256 &gx, __m256 &gy,
+                                              __m256 &gz) {
+    __m256 sin_phi, cos_phi, sin_theta;
+    sincos(_mm256_mul_ps(_mm256_mul_ps(ux, _mm256_set1_ps(Pi)), _mm256_set1_ps(2.0f)), sin_phi,
+           cos_phi);
+    sincos(_mm256_mul_ps(uy, _mm256_set1_ps(Pi)), sin_theta, gz);
+    gx = _mm256_mul_ps(sin_theta, cos_phi);
+    gy = _mm256_mul_ps(sin_theta, sin_phi);
+  }
+};
+template <int C>
+struct TableGradients {
+  const PerlinTable *tables[C];
+
+  template <int D>
+  PSL_AVX2 void operator()(const __m256i *coords, __m256 (*g)[D]) const {
+    __m256i wrapped[D];
+    for (int a = 0; a < D; a++)
+      wrapped[a] = _mm256_and_si256(coords[a], _mm256_set1_epi32(PerlinTable::size - 1));
+    for (int c = 0; c < C; c++) {
+      auto i = _mm256_setzero_si256();
+      for (int a = 0; a < D; a++)
+        i = _mm256_i32gather_epi32(tables[c]->perm, _mm256_add_epi32(i, wrapped[a]), 4);
+      for (int a = 0; a < D; a++)
+        if constexpr (D == 2)
+          g[c][a] = _mm256_i32gather_ps(tables[c]->g2[a], i, 4);
+        else
+          g[c][a] = _mm256_i32gather_ps(tables[c]->g3[a], i, 4);
+    }
+  }
+};
+
+// One octave of `C` channels of Perlin noise at 8 points, sharing the lattice coordinates, fade
+// curves and interpolation weights between channels: `signal[c]` gets the interpolated sum, in
+// about [-1, 1]. With `differentiate`, `dsignal[c]` gets its derivative along each axis
+template <int C, int D, bool differentiate = false, typename Gradients>
+PSL_AVX2 PINE_ALWAYS_INLINE inline void perlin_octave_avx2(const Gradients &gradients,
+                                                           const __m256 *p, __m256 *signal,
+                                                           __m256 (*dsignal)[D] = nullptr) {
+  __m256 cell[D], w[D];
+  for (int a = 0; a < D; a++)
+    w[a] = fade(p[a], cell[a]);
+  for (int c = 0; c < C; c++) {
+    signal[c] = _mm256_setzero_ps();
+    if constexpr (differentiate)
+      for (int a = 0; a < D; a++)
+        dsignal[c][a] = _mm256_setzero_ps();
+  }
+
+  for (int k = 0; k < (1 << D); k++) {
+    __m256i coords[D];
+    __m256 delta[D], axis_w[D];
+    auto corner_w = _mm256_set1_ps(1.0f);
+    for (int a = 0; a < D; a++) {
+      auto o = (k >> (D - 1 - a)) & 1;
+      coords[a] = corner_coord(cell[a], o);
+      delta[a] = corner_delta(w[a], o);
+      axis_w[a] = corner_weight(w[a], o);
+      corner_w = _mm256_mul_ps(corner_w, axis_w[a]);
+    }
+    // The weight's derivative along b is the product of the other axes' weights, signed
+    __m256 dcorner_w[D];
+    if constexpr (differentiate)
+      for (int b = 0; b < D; b++) {
+        dcorner_w[b] = _mm256_set1_ps((k >> (D - 1 - b)) & 1 ? 1.0f : -1.0f);
+        for (int a = 0; a < D; a++)
+          if (a != b)
+            dcorner_w[b] = _mm256_mul_ps(dcorner_w[b], axis_w[a]);
+      }
+    __m256 g[C][D];
+    gradients.template operator()<D>(coords, g);
+    for (int c = 0; c < C; c++) {
+      auto dot = _mm256_mul_ps(g[c][0], delta[0]);
+      for (int a = 1; a < D; a++)
+        dot = _mm256_fmadd_ps(g[c][a], delta[a], dot);
+      signal[c] = _mm256_fmadd_ps(corner_w, dot, signal[c]);
+      if constexpr (differentiate)
+        for (int b = 0; b < D; b++) {
+          dsignal[c][b] = _mm256_fmadd_ps(dcorner_w[b], dot, dsignal[c][b]);
+          dsignal[c][b] = _mm256_fmadd_ps(corner_w, g[c][b], dsignal[c][b]);
+        }
+    }
+  }
+
+  // Through the fade curves, whose slope is 6f(1 - f)
+  if constexpr (differentiate)
+    for (int a = 0; a < D; a++) {
+      auto f = _mm256_sub_ps(p[a], cell[a]);
+      auto slope = _mm256_mul_ps(f, _mm256_sub_ps(_mm256_set1_ps(1.0f), f));
+      slope = _mm256_mul_ps(slope, _mm256_set1_ps(6.0f));
+      for (int c = 0; c < C; c++)
+        dsignal[c][a] = _mm256_mul_ps(dsignal[c][a], slope);
+    }
+}
+
+// Sums the octaves of `C` channels of Perlin noise at 8 points per iteration; `gradients[i]`
+// gives the gradients of octave i. Results are stored `C` per point, normalized and squared like
+// `fbm` unless `raw` is set, which leaves a single octave as plain noise. With `differentiate`,
+// `derivatives` gets the gradient of each result as `fbm_scalar` computes it, D floats each
+template <int C, bool differentiate = false, typename Gradients, typename V>
+PSL_AVX2 void fbm_avx2(const Gradients *gradients, const FbmParams &params, bool raw,
+                       const V *points, float *results, size_t n, float *derivatives = nullptr) {
+  constexpr int D = sizeof(V) / sizeof(float);
+  for (size_t i = 0; i < n; i += 8) {
+    auto m = psl::min(n - i, size_t(8));
+    alignas(32) float lanes[D][8];
+    load_lanes<D>(points + i, m, lanes);
+    __m256 p[D];
+    for (int a = 0; a < D; a++)
+      p[a] = _mm256_load_ps(lanes[a]);
+
+    __m256 accum[C], daccum[C][D];
+    for (int c = 0; c < C; c++) {
+      accum[c] = _mm256_setzero_ps();
+      for (int a = 0; a < D; a++)
+        daccum[c][a] = _mm256_setzero_ps();
+    }
+    auto weight = 1.0f, total = 0.0f, frequency = 1.0f;
+    for (int octave = 0; octave < params.octaves; octave++) {
+      __m256 signal[C], dsignal[C][D];
+      perlin_octave_avx2<C, D, differentiate>(gradients[octave], p, signal, dsignal);
+      for (int c = 0; c < C; c++) {
+        auto noise = _mm256_fmadd_ps(_mm256_set1_ps(0.5f), signal[c], _mm256_set1_ps(0.5f));
+        accum[c] = _mm256_fmadd_ps(_mm256_set1_ps(weight), noise, accum[c]);
+        if constexpr (differentiate)
+          for (int a = 0; a < D; a++)
+            daccum[c][a] = _mm256_fmadd_ps(_mm256_set1_ps(0.5f * weight * frequency),
+                                           dsignal[c][a], daccum[c][a]);
+      }
+      total += weight;
+      weight *= params.gain;
+      frequency *= params.lacunarity;
+      for (int a = 0; a < D; a++)
+        p[a] = _mm256_mul_ps(p[a], _mm256_set1_ps(params.lacunarity));
+    }
+
+    alignas(32) float out[C][8], dout[C][D][8];
+    for (int c = 0; c < C; c++) {
+      if (!raw) {
+        accum[c] = _mm256_div_ps(accum[c], _mm256_set1_ps(total));
+        if constexpr (differentiate) {
+          auto scale = _mm256_mul_ps(accum[c], _mm256_set1_ps(2.0f / total));
+          for (int a = 0; a < D; a++)
+            daccum[c][a] = _mm256_mul_ps(daccum[c][a], scale);
+        }
+        accum[c] = _mm256_mul_ps(accum[c], accum[c]);
+      }
+      _mm256_store_ps(out[c], accum[c]);
+      if constexpr (differentiate)
+        for (int a = 0; a < D; a++)
+          _mm256_store_ps(dout[c][a], daccum[c][a]);
+    }
+    for (size_t j = 0; j < m; j++)
+      for (int c = 0; c < C; c++) {
+        results[(i + j) * C + c] = out[c][j];
+        if constexpr (differentiate)
+          for (int a = 0; a < D; a++)
+            derivatives[((i + j) * C + c) * D + a] = dout[c][a][j];
+      }
+  }
+}
+
+// `fractal_noise` at 8 points per iteration: the warp's D channels first, sharing each octave's
+// lattice, then the shaped octaves at the warped points. `warp_gradients` is unused without a warp
+template <typename Gradients, typename WarpGradients, typename V>
+PSL_AVX2 void fractal_avx2(const Gradients *gradients, const WarpGradients *warp_gradients,
+                           const FractalParams &params, const V *points, float *results,
+                           size_t n) {
+  constexpr int D = sizeof(V) / sizeof(float);
+  auto warp_scale = params.warp / octave_weight_total(params.warp_octaves);
+  auto normalizer = fractal_normalizer(params);
+  auto abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+  for (size_t i = 0; i < n; i += 8) {
+    auto m = psl::min(n - i, size_t(8));
+    alignas(32) float lanes[D][8];
+    load_lanes<D>(points + i, m, lanes);
+    __m256 p[D];
+    for (int a = 0; a < D; a++)
+      p[a] = _mm256_load_ps(lanes[a]);
+
+    if (has_warp(params)) {
+      __m256 wp[D], offset[D];
+      for (int a = 0; a < D; a++) {
+        wp[a] = p[a];
+        offset[a] = _mm256_setzero_ps();
+      }
+      auto weight = 1.0f;
+      for (int octave = 0; octave < params.warp_octaves.octaves; octave++) {
+        __m256 signal[D];
+        perlin_octave_avx2<D, D>(warp_gradients[octave], wp, signal);
+        for (int a = 0; a < D; a++) {
+          offset[a] = _mm256_fmadd_ps(_mm256_set1_ps(weight), signal[a], offset[a]);
+          wp[a] = _mm256_mul_ps(wp[a], _mm256_set1_ps(params.warp_octaves.lacunarity));
+        }
+        weight *= params.warp_octaves.gain;
+      }
+      for (int a = 0; a < D; a++)
+        p[a] = _mm256_fmadd_ps(_mm256_set1_ps(warp_scale), offset[a], p[a]);
+    }
+
+    auto accum = _mm256_setzero_ps(), ridge_weight = _mm256_set1_ps(1.0f);
+    auto weight = 1.0f;
+    for (int octave = 0; octave < params.octaves.octaves; octave++) {
+      __m256 signal;
+      perlin_octave_avx2<1, D>(gradients[octave], p, &signal);
+      switch (params.shape) {
+        case FractalShape::Fbm:
+          signal = _mm256_fmadd_ps(_mm256_set1_ps(0.5f), signal, _mm256_set1_ps(0.5f));
+          break;
+        case FractalShape::Billow: signal = _mm256_and_ps(signal, abs_mask); break;
+        case FractalShape::Ridged:
+          signal = _mm256_sub_ps(_mm256_set1_ps(params.ridge_offset),
+                                 _mm256_and_ps(signal, abs_mask));
+          signal = _mm256_mul_ps(_mm256_mul_ps(signal, signal), ridge_weight);
+          ridge_weight = _mm256_mul_ps(signal, _mm256_set1_ps(params.ridge_gain));
+          ridge_weight = _mm256_min_ps(_mm256_max_ps(ridge_weight, _mm256_setzero_ps()),
+                                       _mm256_set1_ps(1.0f));
+          break;
+      }
+      accum = _mm256_fmadd_ps(_mm256_set1_ps(weight), signal, accum);
+      weight *= params.octaves.gain;
+      for (int a = 0; a < D; a++)
+        p[a] = _mm256_mul_ps(p[a], _mm256_set1_ps(params.octaves.lacunarity));
+    }
+
+    accum = _mm256_div_ps(accum, _mm256_set1_ps(normalizer));
+    if (params.shape == FractalShape::Fbm)
+      accum = _mm256_mul_ps(accum, accum);
+    alignas(32) float out[8];
+    _mm256_store_ps(out, accum);
+    for (size_t j = 0; j < m; j++)
+      results[i + j] = out[j];
+  }
+}
+
+// Calls `f` with the batch kernels' gradients of every octave of `params`, for `C` channels
+template <int C, typename F>
+void with_octave_gradients(const FbmParams &params, F &&f) {
+  auto run = [&]<typename Gradients>(psl::vector<Gradients> gradients) {
+    for (int octave = 0; octave < params.octaves; octave++)
+      for (int c = 0; c < C; c++) {
+        auto seed = octave_seed(params, octave, c);
+        if constexpr (psl::same_as<Gradients, TableGradients<C>>)
+          gradients[octave].tables[c] = &perlin_table(seed);
+        else
+          gradients[octave].seeds[c] = seed;
+      }
+    f(gradients.data());
+  };
+  if (params.gradients == PerlinGradients::Table)
+    run(psl::vector<TableGradients<C>>(params.octaves));
+  else
+    run(psl::vector<HashedGradients<C>>(params.octaves));
+}
+
+// The gradients of one seed at `n` lattice corners, 8 at a time; `coords[a]` and `g[a]` hold
+// the corners' coordinates and gradients along axis a, padded to a multiple of 8
+template <int D, typename Gradients>
+PSL_AVX2 void corner_gradients_avx2(const Gradients &gradients, const int32_t *const *coords,
+                                    float *const *g, size_t n) {
+  for (size_t i = 0; i < n; i += 8) {
+    __m256i c[D];
+    for (int a = 0; a < D; a++)
+      c[a] = _mm256_loadu_si256((const __m256i *)(coords[a] + i));
+    __m256 out[1][D];
+    gradients.template operator()<D>(c, out);
+    for (int a = 0; a < D; a++)
+      _mm256_storeu_ps(g[a] + i, out[0][a]);
+  }
+}
+
+// `bake_octave` at 8 samples along x at a time. The weights are multiplied in float, so the
+// results agree with `fbm` to about 1e-6
+template <int D, int size>
+PSL_AVX2 void bake_octave_avx2(const float (*w)[size], const int32_t (*offset)[size],
+                               const int *stride, bool shared, const float *const *g,
+                               float weight, float *results) {
+  auto one = _mm256_set1_ps(1.0f);
+  auto lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  constexpr int n_rows = psl::powi(size, D - 1);
+  for (int row = 0; row < n_rows; row++) {
+    int i[D] = {};
+    for (int a = 1, rest = row; a < D; rest /= size, a++)
+      i[a] = rest % size;
+    for (int x = 0; x < size; x += 8) {
+      auto s = row * size + x;
+      __m256 wv[D];
+      wv[0] = _mm256_load_ps(w[0] + x);
+      auto base = shared ? _mm256_load_si256((const __m256i *)(offset[0] + x))
+                         : _mm256_slli_epi32(_mm256_add_epi32(_mm256_set1_epi32(s), lanes), D);
+      for (int a = 1; a < D; a++) {
+        wv[a] = _mm256_set1_ps(w[a][i[a]]);
+        if (shared)
+          base = _mm256_add_epi32(base, _mm256_set1_epi32(offset[a][i[a]] * stride[a]));
+      }
+
+      auto sum = _mm256_setzero_ps();
+      for (int k = 0; k < (1 << D); k++) {
+        auto cw = one;
+        auto corner = 0;
+        __m256 delta[D];
+        for (int a = 0; a < D; a++) {
+          auto o = (k >> (D - 1 - a)) & 1;
+          cw = _mm256_mul_ps(cw, o ? wv[a] : _mm256_sub_ps(one, wv[a]));
+          delta[a] = o ? _mm256_sub_ps(wv[a], one) : wv[a];
+          corner += o * stride[a];
+        }
+        auto index = _mm256_add_epi32(base, _mm256_set1_epi32(shared ? corner : k));
+        auto dot = _mm256_mul_ps(_mm256_i32gather_ps(g[0], index, 4), delta[0]);
+        for (int a = 1; a < D; a++)
+          dot = _mm256_fmadd_ps(_mm256_i32gather_ps(g[a], index, 4), delta[a], dot);
+        sum = _mm256_fmadd_ps(cw, dot, sum);
+      }
+      auto noise = _mm256_fmadd_ps(_mm256_set1_ps(0.5f), sum, _mm256_set1_ps(0.5f));
+      auto accum = _mm256_loadu_ps(results + s);
+      _mm256_storeu_ps(results + s, _mm256_fmadd_ps(_mm256_set1_ps(weight), noise, accum));
+    }
+  }
+}
+
+// One octave of simplex noise at 8 points, step for step like the scalar `simplex_noise`
+template <int D>
+PSL_AVX2 __m256 simplex_avx2(const __m256 *p, int seed) {
+  using Lattice = SimplexLattice<D>;
+  auto one = _mm256_set1_ps(1.0f);
+  auto s = p[0];
+  for (int a = 1; a < D; a++)
+    s = _mm256_add_ps(s, p[a]);
+  s = _mm256_mul_ps(s, _mm256_set1_ps(Lattice::skew));
+  __m256 cell[D], d0[D], rank[D];
+  __m256i cell_i[D];
+  auto t = _mm256_setzero_ps();
+  for (int a = 0; a < D; a++) {
+    cell[a] = _mm256_floor_ps(_mm256_add_ps(p[a], s));
+    cell_i[a] = _mm256_cvttps_epi32(cell[a]);
+    t = _mm256_add_ps(t, cell[a]);
+  }
+  t = _mm256_mul_ps(t, _mm256_set1_ps(Lattice::unskew));
+  for (int a = 0; a < D; a++) {
+    d0[a] = _mm256_sub_ps(p[a], _mm256_sub_ps(cell[a], t));
+    rank[a] = _mm256_setzero_ps();
+  }
+  for (int a = 0; a < D; a++)
+    for (int b = a + 1; b < D; b++) {
+      auto greater = _mm256_cmp_ps(d0[a], d0[b], _CMP_GT_OQ);
+      rank[a] = _mm256_add_ps(rank[a], _mm256_and_ps(greater, one));
+      rank[b] = _mm256_add_ps(rank[b], _mm256_andnot_ps(greater, one));
+    }
+
+  auto sum = _mm256_setzero_ps();
+  for (int k = 0; k <= D; k++) {
+    auto falloff = _mm256_set1_ps(Lattice::radius2);
+    auto h = _mm256_set1_epi32(int(uint32_t(seed) * 0x9e3779b9u));
+    __m256 d[D];
+    for (int a = 0; a < D; a++) {
+      auto o = _mm256_cmp_ps(rank[a], _mm256_set1_ps(D - k - 0.5f), _CMP_GT_OQ);
+      // The mask is -1 where the corner is offset
+      auto corner = _mm256_sub_epi32(cell_i[a], _mm256_castps_si256(o));
+      d[a] = _mm256_add_ps(_mm256_sub_ps(d0[a], _mm256_and_ps(o, one)),
+                           _mm256_set1_ps(float(k) * Lattice::unskew));
+      falloff = _mm256_sub_ps(falloff, _mm256_mul_ps(d[a], d[a]));
+      h = _mm256_mullo_epi32(_mm256_xor_si256(h, corner), _mm256_set1_epi32(int(0x85ebca6bu)));
+      h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 13));
+    }
+    h = _mm256_mullo_epi32(h, _mm256_set1_epi32(int(0xc2b2ae35u)));
+    h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 16));
+    auto i = _mm256_srli_epi32(h, 32 - Lattice::gradient_bits);
+
+    auto dot = _mm256_mul_ps(_mm256_i32gather_ps(simplex_gradient<D>(0), i, 4), d[0]);
+    for (int a = 1; a < D; a++) {
+      auto g = _mm256_i32gather_ps(simplex_gradient<D>(a), i, 4);
+      dot = _mm256_add_ps(dot, _mm256_mul_ps(g, d[a]));
+    }
+    falloff = _mm256_max_ps(falloff, _mm256_setzero_ps());
+    falloff = _mm256_mul_ps(falloff, falloff);
+    sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_mul_ps(falloff, falloff), dot));
+  }
+  return _mm256_mul_ps(_mm256_set1_ps(Lattice::scale), sum);
+}
+
+// Octaves of simplex noise at 8 points per iteration, stored like `fbm_avx2` does with one channel
+template <typename V>
+PSL_AVX2 void simplex_fbm_avx2(const FbmParams &params, bool raw, const V *points,
+                               float *results, size_t n) {
+  constexpr int D = sizeof(V) / sizeof(float);
+  for (size_t i = 0; i < n; i += 8) {
+    auto m = psl::min(n - i, size_t(8));
+    alignas(32) float lanes[D][8];
+    load_lanes<D>(points + i, m, lanes);
+    __m256 p[D];
+    for (int a = 0; a < D; a++)
+      p[a] = _mm256_load_ps(lanes[a]);
+
+    auto accum = _mm256_setzero_ps();
+    auto weight = 1.0f, total = 0.0f;
+    for (int octave = 0; octave < params.octaves; octave++) {
+      auto noise = simplex_avx2<D>(p, octave_seed(params, octave, 0));
+      noise = _mm256_fmadd_ps(_mm256_set1_ps(0.5f), noise, _mm256_set1_ps(0.5f));
+      accum = _mm256_fmadd_ps(_mm256_set1_ps(weight), noise, accum);
+      total += weight;
+      weight *= params.gain;
+      for (int a = 0; a < D; a++)
+        p[a] = _mm256_mul_ps(p[a], _mm256_set1_ps(params.lacunarity));
+    }
+    if (!raw) {
+      accum = _mm256_div_ps(accum, _mm256_set1_ps(total));
+      accum = _mm256_mul_ps(accum, accum);
+    }
+    alignas(32) float out[8];
+    _mm256_store_ps(out, accum);
+    for (size_t j = 0; j < m; j++)
+      results[i + j] = out[j];
+  }
+}
+
+
+}  // namespace
+#endif
+
+namespace {
+
+// The gradient of a lattice corner, as `perlin_noise` computes it
+template <typename V, typename Vi>
+V corner_gradient(Vi corner, int seed, PerlinGradients gradients) {
+  constexpr int D = sizeof(V) / sizeof(float);
+  auto g = V();
+  if (gradients == PerlinGradients::Table) {
+    auto &table = perlin_table(seed);
+    auto i = D == 2 ? table.corner(corner[0], corner[1])
+                    : table.corner(corner[0], corner[1], corner[D - 1]);
+    for (int a = 0; a < D; a++)
+      if constexpr (D == 2)
+        g[a] = table.g2[a][i];
+      else
+        g[a] = table.g3[a][i];
+  } else {
+    auto u = RNG{hash(corner, seed)}.next2f();
+    if constexpr (D == 2)
+      g = sample_disk_concentric(u);
+    else
+      g = spherical_to_cartesian(u.x * Pi * 2, u.y * Pi);
+  }
+  return g;
+}
+
+// Octave `octave` of `C` channels of Perlin noise at `np`: `signal[c]` gets the interpolated sum
+// as `perlin_noise` computes it, and `dsignal[c]`, if any, its gradient through the fade curve and
+// corner weights
+template <int C, typename V>
+void perlin_octave(V np, const FbmParams &params, int octave, float *signal,
+                   V *dsignal = nullptr) {
+  constexpr int D = sizeof(V) / sizeof(float);
+  using Vi = psl::Conditional<D == 2, vec2i, vec3i>;
+  auto cell = floor(np);
+  auto f = np - cell;
+  auto w = f * f * (V(3) - 2 * f);
+
+  for (int c = 0; c < C; c++) {
+    signal[c] = 0.0f;
+    if (dsignal)
+      dsignal[c] = V();
+  }
+  for (int k = 0; k < (1 << D); k++) {
+    auto o = Vi();
+    for (int a = 0; a < D; a++)
+      o[a] = (k >> (D - 1 - a)) & 1;
+    // `perlin_interp`'s weight of this corner, in the same double arithmetic
+    auto corner_w = 1.0;
+    for (int a = 0; a < D; a++)
+      corner_w *= o[a] * w[a] + (1 - o[a]) * (1.0 - w[a]);
+    auto delta = w - V(o);
+    auto corner = Vi(cell + o);
+
+    // The weight's derivative along b is the product of the other axes' weights, signed
+    auto dcorner_w = V();
+    if (dsignal)
+      for (int b = 0; b < D; b++) {
+        dcorner_w[b] = o[b] ? 1.0f : -1.0f;
+        for (int a = 0; a < D; a++)
+          if (a != b)
+            dcorner_w[b] *= o[a] ? w[a] : 1.0f - w[a];
+      }
+
+    for (int c = 0; c < C; c++) {
+      auto g = corner_gradient<V>(corner, octave_seed(params, octave, c), params.gradients);
+      auto d = dot(g, delta);
+      signal[c] += corner_w * d;
+      if (dsignal)
+        dsignal[c] += d * dcorner_w + float(corner_w) * g;
+    }
+  }
+
+  // The fade curve's slope is 6f(1 - f)
+  if (dsignal)
+    for (int c = 0; c < C; c++)
+      dsignal[c] *= 6 * f * (V(1) - f);
+}
+
+// `C` channels of fused fbm at one point. For the default parameters this performs the same
+// arithmetic, in the same order, as summing `perlin_noise` octave by octave. `derivatives`, if
+// any, gets each channel's gradient with respect to `np`; `raw` leaves the weighted sum as is,
+// which for one octave is plain noise
+template <int C, typename V>
+void fbm_scalar(V np, const FbmParams &params, float *results, V *derivatives = nullptr,
+                bool raw = false) {
+  float accum[C] = {};
+  V daccum[C] = {};
+  auto weight = 1.0f, total = 0.0f, frequency = 1.0f;
+  for (int octave = 0; octave < params.octaves; octave++) {
+    float signal[C];
+    V dsignal[C];
+    perlin_octave<C>(np, params, octave, signal, derivatives ? dsignal : nullptr);
+    for (int c = 0; c < C; c++) {
+      accum[c] += weight * (0.5f * (1.0f + signal[c]));
+      if (derivatives)
+        daccum[c] += 0.5f * weight * frequency * dsignal[c];
+    }
+    total += weight;
+    weight *= params.gain;
+    frequency *= params.lacunarity;
+    np *= params.lacunarity;
+  }
+  for (int c = 0; c < C; c++) {
+    if (raw) {
+      results[c] = accum[c];
+      if (derivatives)
+        derivatives[c] = daccum[c];
+    } else {
+      auto value = accum[c] / total;
+      results[c] = psl::sqr(value);
+      if (derivatives)
+        derivatives[c] = 2 * value / total * daccum[c];
+    }
+  }
+}
+
+// `fbm_scalar` at every point, through `fbm_avx2` where AVX2 is available
+template <int C, typename V>
+void fbm_batch(psl::span<const V> points, float *results, size_t n, const FbmParams &params,
+               bool raw, float *derivatives = nullptr) {
+  CHECK_EQ(points.size(), n);
+#ifdef PSL_X86
+  if (psl::has_avx2_fma() && params.octaves > 0) {
+    with_octave_gradients<C>(params, [&](auto gradients) {
+      if (derivatives)
+        fbm_avx2<C, true>(gradients, params, raw, points.begin(), results, n, derivatives);
+      else
+        fbm_avx2<C>(gradients, params, raw, points.begin(), results, n);
+    });
+    return;
+  }
+#endif
+  for (size_t i = 0; i < n; i++)
+    fbm_scalar<C>(points[i], params, results + i * C,
+                  derivatives ? (V *)derivatives + i * C : nullptr, raw);
+}
+
+// `fractal_noise` at one point; the `Fbm` shape without a warp is `fbm_scalar`, exactly
+template <typename V>
+float fractal_scalar(V np, const FractalParams &params) {
+  constexpr int D = sizeof(V) / sizeof(float);
+  if (has_warp(params)) {
+    auto wp = np, offset = V();
+    auto weight = 1.0f;
+    for (int octave = 0; octave < params.warp_octaves.octaves; octave++) {
+      float signal[D];
+      perlin_octave<D>(wp, params.warp_octaves, octave, signal);
+      for (int a = 0; a < D; a++)
+        offset[a] += weight * signal[a];
+      weight *= params.warp_octaves.gain;
+      wp *= params.warp_octaves.lacunarity;
+    }
+    np += params.warp / octave_weight_total(params.warp_octaves) * offset;
+  }
+
+  auto accum = 0.0f, weight = 1.0f, ridge_weight = 1.0f;
+  for (int octave = 0; octave < params.octaves.octaves; octave++) {
+    float signal;
+    perlin_octave<1>(np, params.octaves, octave, &signal);
+    switch (params.shape) {
+      case FractalShape::Fbm: signal = 0.5f * (1.0f + signal); break;
+      case FractalShape::Billow: signal = psl::abs(signal); break;
+      case FractalShape::Ridged:
+        signal = psl::sqr(params.ridge_offset - psl::abs(signal)) * ridge_weight;
+        ridge_weight = psl::clamp(signal * params.ridge_gain, 0.0f, 1.0f);
+        break;
+    }
+    accum += weight * signal;
+    weight *= params.octaves.gain;
+    np *= params.octaves.lacunarity;
+  }
+  accum /= fractal_normalizer(params);
+  return params.shape == FractalShape::Fbm ? psl::sqr(accum) : accum;
+}
+
+template <typename V>
+void fractal_batch(psl::span<const V> points, psl::span<float> results,
+                   const FractalParams &params) {
+  constexpr int D = sizeof(V) / sizeof(float);
+  CHECK_EQ(points.size(), results.size());
+#ifdef PSL_X86
+  if (psl::has_avx2_fma() && params.octaves.octaves > 0) {
+    with_octave_gradients<1>(params.octaves, [&](auto gradients) {
+      if (!has_warp(params))
+        fractal_avx2(gradients, (const HashedGradients<D> *)nullptr, params, points.begin(),
+                     results.begin(), results.size());
+      else
+        with_octave_gradients<D>(params.warp_octaves, [&](auto warp_gradients) {
+          fractal_avx2(gradients, warp_gradients, params, points.begin(), results.begin(),
+                       results.size());
+        });
+    });
+    return;
+  }
+#endif
+  for (size_t i = 0; i < results.size(); i++)
+    results[i] = fractal_scalar(points[i], params);
+}
+
+// Octaves of simplex noise at one point, in the same order as `fbm_scalar`
+template <int D>
+float simplex_fbm(const float *p, const FbmParams &params) {
+  float np[D];
+  for (int a = 0; a < D; a++)
+    np[a] = p[a];
+  auto accum = 0.0f, weight = 1.0f, total = 0.0f;
+  for (int octave = 0; octave < params.octaves; octave++) {
+    accum += weight * (0.5f * (1.0f + simplex_noise<D>(np, octave_seed(params, octave, 0))));
+    total += weight;
+    weight *= params.gain;
+    for (int a = 0; a < D; a++)
+      np[a] *= params.lacunarity;
+  }
+  return psl::sqr(accum / total);
+}
+
+template <typename V>
+void simplex_batch(psl::span<const V> points, psl::span<float> results, const FbmParams &params,
+                   bool raw) {
+  constexpr int D = sizeof(V) / sizeof(float);
+  CHECK_EQ(points.size(), results.size());
+#ifdef PSL_X86
+  if (psl::has_avx2_fma() && params.octaves > 0) {
+    simplex_fbm_avx2(params, raw, points.begin(), results.begin(), results.size());
+    return;
+  }
+#endif
+  for (size_t i = 0; i < results.size(); i++) {
+    if (raw)
+      results[i] = simplex_noise(points[i], params.seed);
+    else
+      results[i] = simplex_fbm<D>(&points[i][0], params);
+  }
+}
+
+}  // namespace
+
+void perlin_noise(psl::span<const vec2> points, psl::span<float> results, int seed,
+                  PerlinGradients gradients) {
+  auto params = FbmParams{.octaves = 1, .seed = seed, .gradients = gradients};
+  fbm_batch<1>(points, results.begin(), results.size(), params, true);
+}
+void perlin_noise(psl::span<const vec3> points, psl::span<float> results, int seed,
+                  PerlinGradients gradients) {
+  auto params = FbmParams{.octaves = 1, .seed = seed, .gradients = gradients};
+  fbm_batch<1>(points, results.begin(), results.size(), params, true);
+}
+
 template <typename T, typename P>
 T fbm(T (*noise)(P, int), P np, int octaves) {
   auto accum = T();
@@ -74,590 +1232,548 @@ T fbm(T (*noise)(P, int), P np, int octaves) {
   return psl::sqr(accum / (2.0f - weight * 2));
 }
 
-
 float fbm(float np, int octaves) {
   return fbm<float>(perlin_noise, np, octaves);
 }
 float fbm(vec2 np, int octaves) {
-  return fbm<float>(perlin_noise, np, octaves);
+  return fbm(np, FbmParams{.octaves = octaves});
 }
 float fbm(vec3 np, int octaves) {
-  return fbm<float>(perlin_noise, np, octaves);
+  return fbm(np, FbmParams{.octaves = octaves});
 }
 vec2 fbm2d(float np, int octaves) {
   return fbm<vec2>(perlin_noise2d, np, octaves);
 }
 vec2 fbm2d(vec2 np, int octaves) {
-  return fbm<vec2>(perlin_noise2d, np, octaves);
+  return fbm2d(np, FbmParams{.octaves = octaves});
 }
 vec2 fbm2d(vec3 np, int octaves) {
-  return fbm<vec2>(perlin_noise2d, np, octaves);
+  return fbm2d(np, FbmParams{.octaves = octaves});
 }
 vec3 fbm3d(float np, int octaves) {
   return fbm<vec3>(perlin_noise3d, np, octaves);
 }
 vec3 fbm3d(vec2 np, int octaves) {
-  return fbm<vec3>(perlin_noise3d, np, octaves);
+  return fbm3d(np, FbmParams{.octaves = octaves});
 }
 vec3 fbm3d(vec3 np, int octaves) {
-  return fbm<vec3>(perlin_noise3d, np, octaves);
+  return fbm3d(np, FbmParams{.octaves = octaves});
 }
 
-}  // namespace pine
+float fbm(vec2 np, const FbmParams &params) {
+  float result;
+  fbm_scalar<1>(np, params, &result);
+  return result;
+}
+float fbm(vec3 np, const FbmParams &params) {
+  float result;
+  fbm_scalar<1>(np, params, &result);
+  return result;
+}
+vec2 fbm2d(vec2 np, const FbmParams &params) {
+  float results[2];
+  fbm_scalar<2>(np, params, results);
+  return {results[0], results[1]};
+}
+vec2 fbm2d(vec3 np, const FbmParams &params) {
+  float results[2];
+  fbm_scalar<2>(np, params, results);
+  return {results[0], results[1]};
+}
+vec3 fbm3d(vec2 np, const FbmParams &params) {
+  float results[3];
+  fbm_scalar<3>(np, params, results);
+  return {results[0], results[1], results[2]};
+}
+vec3 fbm3d(vec3 np, const FbmParams &params) {
+  float results[3];
+  fbm_scalar<3>(np, params, results);
+  return {results[0], results[1], results[2]};
+}
 
-// // SimplexNoise1234
-// // Copyright 2003-2011, Stefan Gustavson
-// //
-// // Contact: stegu@itn.liu.se
-// //
-// // This library is public domain software, released by the author
-// // into the public domain in February 2011. You may do anything
-// // you like with it. You may even remove all attributions,
-// // but of course I'd appreciate it if you kept my name somewhere.
-// //
-// // This library is distributed in the hope that it will be useful,
-// // but WITHOUT ANY WARRANTY; without even the implied warranty of
-// // MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
-// // General Public License for more details.
-
-// /** \file
-//                 \brief Declares the SimplexNoise1234 class for producing Perlin simplex noise.
-//                 \author Stefan Gustavson (stegu@itn.liu.se)
-// */
-
-// /*
-//  * This is a clean, fast, modern and free Perlin Simplex noise class in C++.
-//  * Being a stand-alone class with no external dependencies, it is
-//  * highly reusable without source code modifications.
-//  *
-//  *
-//  * Note:
-//  * Replacing the "float" type with "double" can actually make this run faster
-//  * on some platforms. A templatized version of SimplexNoise1234 could be useful.
-//  */
-
-// class SimplexNoise1234 {
-// public:
-//   static float noise(float x);
-//   static float noise(float x, float y);
-//   static float noise(float x, float y, float z);
-//   static float noise(float x, float y, float z, float w);
-
-//   static float pnoise(float x, int px);
-//   static float pnoise(float x, float y, int px, int py);
-//   static float pnoise(float x, float y, float z, int px, int py, int pz);
-//   static float pnoise(float x, float y, float z, float w, int px, int py, int pz, int pw);
-
-// private:
-//   static unsigned char perm[];
-//   static float grad(int hash, float x);
-//   static float grad(int hash, float x, float y);
-//   static float grad(int hash, float x, float y, float z);
-//   static float grad(int hash, float x, float y, float z, float t);
-// };
-
-// #define FASTFLOOR(x) (((x) > 0) ? ((int)x) : (((int)x) - 1))
-
-// //---------------------------------------------------------------------
-// // Static data
-
-// /*
-//  * Permutation table. This is just a random jumble of all numbers 0-255,
-//  * repeated twice to avoid wrapping the index at 255 for each lookup.
-//  * This needs to be exactly the same for all instances on all platforms,
-//  * so it's easiest to just keep it as static explicit data.
-//  * This also removes the need for any initialisation of this class.
-//  *
-//  * Note that making this an int[] instead of a char[] might make the
-//  * code run faster on platforms with a high penalty for unaligned single
-//  * byte addressing. Intel x86 is generally single-byte-friendly, but
-//  * some other CPUs are faster with 4-aligned reads.
-//  * However, a char[] is smaller, which avoids cache trashing, and that
-//  * is probably the most important aspect on most architectures.
-//  * This array is accessed a *lot* by the noise functions.
-//  * A vector-valued noise over 3D accesses it 96 times, and a
-//  * float-valued 4D noise 64 times. We want this to fit in the cache!
-//  */
-// unsigned char SimplexNoise1234::perm[512] = {
-//     151, 160, 137, 91,  90,  15,  131, 13,  201, 95,  96,  53,  194, 233, 7,   225, 140, 36, 103,
-//     30,  69,  142, 8,   99,  37,  240, 21,  10,  23,  190, 6,   148, 247, 120, 234, 75,  0,   26,
-//     197, 62,  94,  252, 219, 203, 117, 35,  11,  32,  57,  177, 33,  88,  237, 149, 56,  87, 174,
-//     20,  125, 136, 171, 168, 68,  175, 74,  165, 71,  134, 139, 48,  27,  166, 77,  146, 158,
-//     231, 83,  111, 229, 122, 60,  211, 133, 230, 220, 105, 92,  41,  55,  46,  245, 40,  244,
-//     102, 143, 54,  65,  25,  63,  161, 1,   216, 80,  73,  209, 76,  132, 187, 208, 89,  18, 169,
-//     200, 196, 135, 130, 116, 188, 159, 86,  164, 100, 109, 198, 173, 186, 3,   64,  52,  217,
-//     226, 250, 124, 123, 5,   202, 38,  147, 118, 126, 255, 82,  85,  212, 207, 206, 59,  227, 47,
-//     16,  58,  17, 182, 189, 28,  42,  223, 183, 170, 213, 119, 248, 152, 2,   44,  154, 163, 70,
-//     221, 153, 101, 155, 167, 43,  172, 9,   129, 22,  39,  253, 19,  98,  108, 110, 79,  113,
-//     224, 232, 178, 185, 112, 104, 218, 246, 97,  228, 251, 34,  242, 193, 238, 210, 144, 12, 191,
-//     179, 162, 241, 81, 51,  145, 235, 249, 14,  239, 107, 49,  192, 214, 31,  181, 199, 106, 157,
-//     184, 84,  204, 176, 115, 121, 50,  45,  127, 4,   150, 254, 138, 236, 205, 93,  222, 114, 67,
-//     29,  24,  72,  243, 141, 128, 195, 78,  66,  215, 61,  156, 180, 151, 160, 137, 91,  90,  15,
-//     131, 13,  201, 95, 96,  53,  194, 233, 7,   225, 140, 36,  103, 30,  69,  142, 8,   99,  37,
-//     240, 21,  10,  23, 190, 6,   148, 247, 120, 234, 75,  0,   26,  197, 62,  94,  252, 219, 203,
-//     117, 35,  11,  32, 57,  177, 33,  88,  237, 149, 56,  87,  174, 20,  125, 136, 171, 168, 68,
-//     175, 74,  165, 71, 134, 139, 48,  27,  166, 77,  146, 158, 231, 83,  111, 229, 122, 60,  211,
-//     133, 230, 220, 105, 92,  41,  55,  46,  245, 40,  244, 102, 143, 54,  65,  25,  63,  161, 1,
-//     216, 80,  73,  209, 76,  132, 187, 208, 89,  18,  169, 200, 196, 135, 130, 116, 188, 159, 86,
-//     164, 100, 109, 198, 173, 186, 3,   64,  52,  217, 226, 250, 124, 123, 5,   202, 38,  147,
-//     118, 126, 255, 82,  85, 212, 207, 206, 59,  227, 47,  16,  58,  17,  182, 189, 28,  42,  223,
-//     183, 170, 213, 119, 248, 152, 2,   44,  154, 163, 70,  221, 153, 101, 155, 167, 43,  172, 9,
-//     129, 22,  39,  253, 19, 98,  108, 110, 79,  113, 224, 232, 178, 185, 112, 104, 218, 246, 97,
-//     228, 251, 34,  242, 193, 238, 210, 144, 12,  191, 179, 162, 241, 81,  51,  145, 235, 249, 14,
-//     239, 107, 49,  192, 214, 31,  181, 199, 106, 157, 184, 84,  204, 176, 115, 121, 50,  45, 127,
-//     4,   150, 254, 138, 236, 205, 93,  222, 114, 67,  29,  24,  72,  243, 141, 128, 195, 78,  66,
-//     215, 61,  156, 180};
-
-// //---------------------------------------------------------------------
-
-// /*
-//  * Helper functions to compute gradients-dot-residualvectors (1D to 4D)
-//  * Note that these generate gradients of more than unit length. To make
-//  * a close match with the value range of classic Perlin noise, the final
-//  * noise values need to be rescaled to fit nicely within [-1,1].
-//  * (The simplex noise functions as such also have different scaling.)
-//  * Note also that these noise functions are the most practical and useful
-//  * signed version of Perlin noise. To return values according to the
-//  * RenderMan specification from the SL noise() and pnoise() functions,
-//  * the noise values need to be scaled and offset to [0,1], like this:
-//  * float SLnoise = (SimplexNoise1234::noise(x,y,z) + 1.0) * 0.5;
-//  */
-
-// float SimplexNoise1234::grad(int hash, float x) {
-//   int h = hash & 15;
-//   float grad = 1.0f + (h & 7);  // Gradient value 1.0, 2.0, ..., 8.0
-//   if (h & 8)
-//     grad = -grad;     // Set a random sign for the gradient
-//   return (grad * x);  // Multiply the gradient with the distance
-// }
-
-// float SimplexNoise1234::grad(int hash, float x, float y) {
-//   int h = hash & 7;         // Convert low 3 bits of hash code
-//   float u = h < 4 ? x : y;  // into 8 simple gradient directions,
-//   float v = h < 4 ? y : x;  // and compute the dot product with (x,y).
-//   return ((h & 1) ? -u : u) + ((h & 2) ? -2.0f * v : 2.0f * v);
-// }
-
-// float SimplexNoise1234::grad(int hash, float x, float y, float z) {
-//   int h = hash & 15;        // Convert low 4 bits of hash code into 12 simple
-//   float u = h < 8 ? x : y;  // gradient directions, and compute dot product.
-//   float v = h < 4 ? y : h == 12 || h == 14 ? x : z;  // Fix repeats at h = 12 to 15
-//   return ((h & 1) ? -u : u) + ((h & 2) ? -v : v);
-// }
-
-// float SimplexNoise1234::grad(int hash, float x, float y, float z, float t) {
-//   int h = hash & 31;         // Convert low 5 bits of hash code into 32 simple
-//   float u = h < 24 ? x : y;  // gradient directions, and compute dot product.
-//   float v = h < 16 ? y : z;
-//   float w = h < 8 ? z : t;
-//   return ((h & 1) ? -u : u) + ((h & 2) ? -v : v) + ((h & 4) ? -w : w);
-// }
-
-// // A lookup table to traverse the simplex around a given point in 4D.
-// // Details can be found where this table is used, in the 4D noise method.
-// /* TODO: This should not be required, backport it from Bill's GLSL code! */
-// static unsigned char simplex[64][4] = {
-//     {0, 1, 2, 3}, {0, 1, 3, 2}, {0, 0, 0, 0}, {0, 2, 3, 1}, {0, 0, 0, 0}, {0, 0, 0, 0},
-//     {0, 0, 0, 0}, {1, 2, 3, 0}, {0, 2, 1, 3}, {0, 0, 0, 0}, {0, 3, 1, 2}, {0, 3, 2, 1},
-//     {0, 0, 0, 0}, {0, 0, 0, 0}, {0, 0, 0, 0}, {1, 3, 2, 0}, {0, 0, 0, 0}, {0, 0, 0, 0},
-//     {0, 0, 0, 0}, {0, 0, 0, 0}, {0, 0, 0, 0}, {0, 0, 0, 0}, {0, 0, 0, 0}, {0, 0, 0, 0},
-//     {1, 2, 0, 3}, {0, 0, 0, 0}, {1, 3, 0, 2}, {0, 0, 0, 0}, {0, 0, 0, 0}, {0, 0, 0, 0},
-//     {2, 3, 0, 1}, {2, 3, 1, 0}, {1, 0, 2, 3}, {1, 0, 3, 2}, {0, 0, 0, 0}, {0, 0, 0, 0},
-//     {0, 0, 0, 0}, {2, 0, 3, 1}, {0, 0, 0, 0}, {2, 1, 3, 0}, {0, 0, 0, 0}, {0, 0, 0, 0},
-//     {0, 0, 0, 0}, {0, 0, 0, 0}, {0, 0, 0, 0}, {0, 0, 0, 0}, {0, 0, 0, 0}, {0, 0, 0, 0},
-//     {2, 0, 1, 3}, {0, 0, 0, 0}, {0, 0, 0, 0}, {0, 0, 0, 0}, {3, 0, 1, 2}, {3, 0, 2, 1},
-//     {0, 0, 0, 0}, {3, 1, 2, 0}, {2, 1, 0, 3}, {0, 0, 0, 0}, {0, 0, 0, 0}, {0, 0, 0, 0},
-//     {3, 1, 0, 2}, {0, 0, 0, 0}, {3, 2, 0, 1}, {3, 2, 1, 0}};
-
-// // 1D simplex noise
-// float SimplexNoise1234::noise(float x) {
-//   int i0 = FASTFLOOR(x);
-//   int i1 = i0 + 1;
-//   float x0 = x - i0;
-//   float x1 = x0 - 1.0f;
-
-//   float n0, n1;
-
-//   float t0 = 1.0f - x0 * x0;
-//   //  if(t0 < 0.0f) t0 = 0.0f;
-//   t0 *= t0;
-//   n0 = t0 * t0 * grad(perm[i0 & 0xff], x0);
-
-//   float t1 = 1.0f - x1 * x1;
-//   //  if(t1 < 0.0f) t1 = 0.0f;
-//   t1 *= t1;
-//   n1 = t1 * t1 * grad(perm[i1 & 0xff], x1);
-//   // The maximum value of this noise is 8*(3/4)^4 = 2.53125
-//   // A factor of 0.395 would scale to fit exactly within [-1,1], but
-//   // we want to match PRMan's 1D noise, so we scale it down some more.
-//   return 0.25f * (n0 + n1);
-// }
-
-// // 2D simplex noise
-// float SimplexNoise1234::noise(float x, float y) {
-// #define F2 0.366025403f  // F2 = 0.5*(sqrt(3.0)-1.0)
-// #define G2 0.211324865f  // G2 = (3.0-Math.sqrt(3.0))/6.0
-
-//   float n0, n1, n2;  // Noise contributions from the three corners
-
-//   // Skew the input space to determine which simplex cell we're in
-//   float s = (x + y) * F2;  // Hairy factor for 2D
-//   float xs = x + s;
-//   float ys = y + s;
-//   int i = FASTFLOOR(xs);
-//   int j = FASTFLOOR(ys);
-
-//   float t = (float)(i + j) * G2;
-//   float X0 = i - t;  // Unskew the cell origin back to (x,y) space
-//   float Y0 = j - t;
-//   float x0 = x - X0;  // The x,y distances from the cell origin
-//   float y0 = y - Y0;
-
-//   // For the 2D case, the simplex shape is an equilateral triangle.
-//   // Determine which simplex we are in.
-//   int i1, j1;  // Offsets for second (middle) corner of simplex in (i,j) coords
-//   if (x0 > y0) {
-//     i1 = 1;
-//     j1 = 0;
-//   }  // lower triangle, XY order: (0,0)->(1,0)->(1,1)
-//   else {
-//     i1 = 0;
-//     j1 = 1;
-//   }  // upper triangle, YX order: (0,0)->(0,1)->(1,1)
-
-//   // A step of (1,0) in (i,j) means a step of (1-c,-c) in (x,y), and
-//   // a step of (0,1) in (i,j) means a step of (-c,1-c) in (x,y), where
-//   // c = (3-sqrt(3))/6
-
-//   float x1 = x0 - i1 + G2;  // Offsets for middle corner in (x,y) unskewed coords
-//   float y1 = y0 - j1 + G2;
-//   float x2 = x0 - 1.0f + 2.0f * G2;  // Offsets for last corner in (x,y) unskewed coords
-//   float y2 = y0 - 1.0f + 2.0f * G2;
-
-//   // Wrap the integer indices at 256, to avoid indexing perm[] out of bounds
-//   int ii = i & 0xff;
-//   int jj = j & 0xff;
-
-//   // Calculate the contribution from the three corners
-//   float t0 = 0.5f - x0 * x0 - y0 * y0;
-//   if (t0 < 0.0f)
-//     n0 = 0.0f;
-//   else {
-//     t0 *= t0;
-//     n0 = t0 * t0 * grad(perm[ii + perm[jj]], x0, y0);
-//   }
-
-//   float t1 = 0.5f - x1 * x1 - y1 * y1;
-//   if (t1 < 0.0f)
-//     n1 = 0.0f;
-//   else {
-//     t1 *= t1;
-//     n1 = t1 * t1 * grad(perm[ii + i1 + perm[jj + j1]], x1, y1);
-//   }
-
-//   float t2 = 0.5f - x2 * x2 - y2 * y2;
-//   if (t2 < 0.0f)
-//     n2 = 0.0f;
-//   else {
-//     t2 *= t2;
-//     n2 = t2 * t2 * grad(perm[ii + 1 + perm[jj + 1]], x2, y2);
-//   }
-
-//   // Add contributions from each corner to get the final noise value.
-//   // The result is scaled to return values in the interval [-1,1].
-//   return 40.0f * (n0 + n1 + n2);  // TODO: The scale factor is preliminary!
-// }
-
-// // 3D simplex noise
-// float SimplexNoise1234::noise(float x, float y, float z) {
-// // Simple skewing factors for the 3D case
-// #define F3 0.333333333f
-// #define G3 0.166666667f
-
-//   float n0, n1, n2, n3;  // Noise contributions from the four corners
-
-//   // Skew the input space to determine which simplex cell we're in
-//   float s = (x + y + z) * F3;  // Very nice and simple skew factor for 3D
-//   float xs = x + s;
-//   float ys = y + s;
-//   float zs = z + s;
-//   int i = FASTFLOOR(xs);
-//   int j = FASTFLOOR(ys);
-//   int k = FASTFLOOR(zs);
-
-//   float t = (float)(i + j + k) * G3;
-//   float X0 = i - t;  // Unskew the cell origin back to (x,y,z) space
-//   float Y0 = j - t;
-//   float Z0 = k - t;
-//   float x0 = x - X0;  // The x,y,z distances from the cell origin
-//   float y0 = y - Y0;
-//   float z0 = z - Z0;
-
-//   // For the 3D case, the simplex shape is a slightly irregular tetrahedron.
-//   // Determine which simplex we are in.
-//   int i1, j1, k1;  // Offsets for second corner of simplex in (i,j,k) coords
-//   int i2, j2, k2;  // Offsets for third corner of simplex in (i,j,k) coords
-
-//   /* This code would benefit from a backport from the GLSL version! */
-//   if (x0 >= y0) {
-//     if (y0 >= z0) {
-//       i1 = 1;
-//       j1 = 0;
-//       k1 = 0;
-//       i2 = 1;
-//       j2 = 1;
-//       k2 = 0;
-//     }  // X Y Z order
-//     else if (x0 >= z0) {
-//       i1 = 1;
-//       j1 = 0;
-//       k1 = 0;
-//       i2 = 1;
-//       j2 = 0;
-//       k2 = 1;
-//     }  // X Z Y order
-//     else {
-//       i1 = 0;
-//       j1 = 0;
-//       k1 = 1;
-//       i2 = 1;
-//       j2 = 0;
-//       k2 = 1;
-//     }       // Z X Y order
-//   } else {  // x0<y0
-//     if (y0 < z0) {
-//       i1 = 0;
-//       j1 = 0;
-//       k1 = 1;
-//       i2 = 0;
-//       j2 = 1;
-//       k2 = 1;
-//     }  // Z Y X order
-//     else if (x0 < z0) {
-//       i1 = 0;
-//       j1 = 1;
-//       k1 = 0;
-//       i2 = 0;
-//       j2 = 1;
-//       k2 = 1;
-//     }  // Y Z X order
-//     else {
-//       i1 = 0;
-//       j1 = 1;
-//       k1 = 0;
-//       i2 = 1;
-//       j2 = 1;
-//       k2 = 0;
-//     }  // Y X Z order
-//   }
-
-//   // A step of (1,0,0) in (i,j,k) means a step of (1-c,-c,-c) in (x,y,z),
-//   // a step of (0,1,0) in (i,j,k) means a step of (-c,1-c,-c) in (x,y,z), and
-//   // a step of (0,0,1) in (i,j,k) means a step of (-c,-c,1-c) in (x,y,z), where
-//   // c = 1/6.
-
-//   float x1 = x0 - i1 + G3;  // Offsets for second corner in (x,y,z) coords
-//   float y1 = y0 - j1 + G3;
-//   float z1 = z0 - k1 + G3;
-//   float x2 = x0 - i2 + 2.0f * G3;  // Offsets for third corner in (x,y,z) coords
-//   float y2 = y0 - j2 + 2.0f * G3;
-//   float z2 = z0 - k2 + 2.0f * G3;
-//   float x3 = x0 - 1.0f + 3.0f * G3;  // Offsets for last corner in (x,y,z) coords
-//   float y3 = y0 - 1.0f + 3.0f * G3;
-//   float z3 = z0 - 1.0f + 3.0f * G3;
-
-//   // Wrap the integer indices at 256, to avoid indexing perm[] out of bounds
-//   int ii = i & 0xff;
-//   int jj = j & 0xff;
-//   int kk = k & 0xff;
-
-//   // Calculate the contribution from the four corners
-//   float t0 = 0.6f - x0 * x0 - y0 * y0 - z0 * z0;
-//   if (t0 < 0.0f)
-//     n0 = 0.0f;
-//   else {
-//     t0 *= t0;
-//     n0 = t0 * t0 * grad(perm[ii + perm[jj + perm[kk]]], x0, y0, z0);
-//   }
-
-//   float t1 = 0.6f - x1 * x1 - y1 * y1 - z1 * z1;
-//   if (t1 < 0.0f)
-//     n1 = 0.0f;
-//   else {
-//     t1 *= t1;
-//     n1 = t1 * t1 * grad(perm[ii + i1 + perm[jj + j1 + perm[kk + k1]]], x1, y1, z1);
-//   }
-
-//   float t2 = 0.6f - x2 * x2 - y2 * y2 - z2 * z2;
-//   if (t2 < 0.0f)
-//     n2 = 0.0f;
-//   else {
-//     t2 *= t2;
-//     n2 = t2 * t2 * grad(perm[ii + i2 + perm[jj + j2 + perm[kk + k2]]], x2, y2, z2);
-//   }
-
-//   float t3 = 0.6f - x3 * x3 - y3 * y3 - z3 * z3;
-//   if (t3 < 0.0f)
-//     n3 = 0.0f;
-//   else {
-//     t3 *= t3;
-//     n3 = t3 * t3 * grad(perm[ii + 1 + perm[jj + 1 + perm[kk + 1]]], x3, y3, z3);
-//   }
-
-//   // Add contributions from each corner to get the final noise value.
-//   // The result is scaled to stay just inside [-1,1]
-//   return 32.0f * (n0 + n1 + n2 + n3);  // TODO: The scale factor is preliminary!
-// }
-
-// // 4D simplex noise
-// float SimplexNoise1234::noise(float x, float y, float z, float w) {
-//   // The skewing and unskewing factors are hairy again for the 4D case
-// #define F4 0.309016994f  // F4 = (Math.sqrt(5.0)-1.0)/4.0
-// #define G4 0.138196601f  // G4 = (5.0-Math.sqrt(5.0))/20.0
-
-//   float n0, n1, n2, n3, n4;  // Noise contributions from the five corners
-
-//   // Skew the (x,y,z,w) space to determine which cell of 24 simplices we're in
-//   float s = (x + y + z + w) * F4;  // Factor for 4D skewing
-//   float xs = x + s;
-//   float ys = y + s;
-//   float zs = z + s;
-//   float ws = w + s;
-//   int i = FASTFLOOR(xs);
-//   int j = FASTFLOOR(ys);
-//   int k = FASTFLOOR(zs);
-//   int l = FASTFLOOR(ws);
-
-//   float t = (i + j + k + l) * G4;  // Factor for 4D unskewing
-//   float X0 = i - t;                // Unskew the cell origin back to (x,y,z,w) space
-//   float Y0 = j - t;
-//   float Z0 = k - t;
-//   float W0 = l - t;
-
-//   float x0 = x - X0;  // The x,y,z,w distances from the cell origin
-//   float y0 = y - Y0;
-//   float z0 = z - Z0;
-//   float w0 = w - W0;
-
-//   // For the 4D case, the simplex is a 4D shape I won't even try to describe.
-//   // To find out which of the 24 possible simplices we're in, we need to
-//   // determine the magnitude ordering of x0, y0, z0 and w0.
-//   // The method below is a good way of finding the ordering of x,y,z,w and
-//   // then find the correct traversal order for the simplex we�re in.
-//   // First, six pair-wise comparisons are performed between each possible pair
-//   // of the four coordinates, and the results are used to add up binary bits
-//   // for an integer index.
-//   int c1 = (x0 > y0) ? 32 : 0;
-//   int c2 = (x0 > z0) ? 16 : 0;
-//   int c3 = (y0 > z0) ? 8 : 0;
-//   int c4 = (x0 > w0) ? 4 : 0;
-//   int c5 = (y0 > w0) ? 2 : 0;
-//   int c6 = (z0 > w0) ? 1 : 0;
-//   int c = c1 + c2 + c3 + c4 + c5 + c6;
-
-//   int i1, j1, k1, l1;  // The integer offsets for the second simplex corner
-//   int i2, j2, k2, l2;  // The integer offsets for the third simplex corner
-//   int i3, j3, k3, l3;  // The integer offsets for the fourth simplex corner
-
-//   // simplex[c] is a 4-vector with the numbers 0, 1, 2 and 3 in some order.
-//   // Many values of c will never occur, since e.g. x>y>z>w makes x<z, y<w and x<w
-//   // impossible. Only the 24 indices which have non-zero entries make any sense.
-//   // We use a thresholding to set the coordinates in turn from the largest magnitude.
-//   // The number 3 in the "simplex" array is at the position of the largest coordinate.
-//   i1 = simplex[c][0] >= 3 ? 1 : 0;
-//   j1 = simplex[c][1] >= 3 ? 1 : 0;
-//   k1 = simplex[c][2] >= 3 ? 1 : 0;
-//   l1 = simplex[c][3] >= 3 ? 1 : 0;
-//   // The number 2 in the "simplex" array is at the second largest coordinate.
-//   i2 = simplex[c][0] >= 2 ? 1 : 0;
-//   j2 = simplex[c][1] >= 2 ? 1 : 0;
-//   k2 = simplex[c][2] >= 2 ? 1 : 0;
-//   l2 = simplex[c][3] >= 2 ? 1 : 0;
-//   // The number 1 in the "simplex" array is at the second smallest coordinate.
-//   i3 = simplex[c][0] >= 1 ? 1 : 0;
-//   j3 = simplex[c][1] >= 1 ? 1 : 0;
-//   k3 = simplex[c][2] >= 1 ? 1 : 0;
-//   l3 = simplex[c][3] >= 1 ? 1 : 0;
-//   // The fifth corner has all coordinate offsets = 1, so no need to look that up.
-
-//   float x1 = x0 - i1 + G4;  // Offsets for second corner in (x,y,z,w) coords
-//   float y1 = y0 - j1 + G4;
-//   float z1 = z0 - k1 + G4;
-//   float w1 = w0 - l1 + G4;
-//   float x2 = x0 - i2 + 2.0f * G4;  // Offsets for third corner in (x,y,z,w) coords
-//   float y2 = y0 - j2 + 2.0f * G4;
-//   float z2 = z0 - k2 + 2.0f * G4;
-//   float w2 = w0 - l2 + 2.0f * G4;
-//   float x3 = x0 - i3 + 3.0f * G4;  // Offsets for fourth corner in (x,y,z,w) coords
-//   float y3 = y0 - j3 + 3.0f * G4;
-//   float z3 = z0 - k3 + 3.0f * G4;
-//   float w3 = w0 - l3 + 3.0f * G4;
-//   float x4 = x0 - 1.0f + 4.0f * G4;  // Offsets for last corner in (x,y,z,w) coords
-//   float y4 = y0 - 1.0f + 4.0f * G4;
-//   float z4 = z0 - 1.0f + 4.0f * G4;
-//   float w4 = w0 - 1.0f + 4.0f * G4;
-
-//   // Wrap the integer indices at 256, to avoid indexing perm[] out of bounds
-//   int ii = i & 0xff;
-//   int jj = j & 0xff;
-//   int kk = k & 0xff;
-//   int ll = l & 0xff;
-
-//   // Calculate the contribution from the five corners
-//   float t0 = 0.6f - x0 * x0 - y0 * y0 - z0 * z0 - w0 * w0;
-//   if (t0 < 0.0f)
-//     n0 = 0.0f;
-//   else {
-//     t0 *= t0;
-//     n0 = t0 * t0 * grad(perm[ii + perm[jj + perm[kk + perm[ll]]]], x0, y0, z0, w0);
-//   }
-
-//   float t1 = 0.6f - x1 * x1 - y1 * y1 - z1 * z1 - w1 * w1;
-//   if (t1 < 0.0f)
-//     n1 = 0.0f;
-//   else {
-//     t1 *= t1;
-//     n1 = t1 * t1 *
-//          grad(perm[ii + i1 + perm[jj + j1 + perm[kk + k1 + perm[ll + l1]]]], x1, y1, z1, w1);
-//   }
-
-//   float t2 = 0.6f - x2 * x2 - y2 * y2 - z2 * z2 - w2 * w2;
-//   if (t2 < 0.0f)
-//     n2 = 0.0f;
-//   else {
-//     t2 *= t2;
-//     n2 = t2 * t2 *
-//          grad(perm[ii + i2 + perm[jj + j2 + perm[kk + k2 + perm[ll + l2]]]], x2, y2, z2, w2);
-//   }
-
-//   float t3 = 0.6f - x3 * x3 - y3 * y3 - z3 * z3 - w3 * w3;
-//   if (t3 < 0.0f)
-//     n3 = 0.0f;
-//   else {
-//     t3 *= t3;
-//     n3 = t3 * t3 *
-//          grad(perm[ii + i3 + perm[jj + j3 + perm[kk + k3 + perm[ll + l3]]]], x3, y3, z3, w3);
-//   }
-
-//   float t4 = 0.6f - x4 * x4 - y4 * y4 - z4 * z4 - w4 * w4;
-//   if (t4 < 0.0f)
-//     n4 = 0.0f;
-//   else {
-//     t4 *= t4;
-//     n4 = t4 * t4 * grad(perm[ii + 1 + perm[jj + 1 + perm[kk + 1 + perm[ll + 1]]]], x4, y4, z4,
-//     w4);
-//   }
-
-//   // Sum up and scale the result to cover the range [-1,1]
-//   return 27.0f * (n0 + n1 + n2 + n3 + n4);  // TODO: The scale factor is preliminary!
-// }
-
-// float simplex_noise(vec3 p, float frequency) {
-//   p *= frequency;
-//   return SimplexNoise1234().noise(p.x, p.y, p.z);
-// }
-// vec3 simplex_noise3d(vec3 p, float frequency) {
-//   p *= frequency;
-//   auto x = SimplexNoise1234().noise(p.x, p.y, p.z);
-//   return vec3(hashf(x, 10), hashf(x, 29485), hashf(x, 294855918331));
-// }
\ No newline at end of file
+void fbm(psl::span<const vec2> points, psl::span<float> results, const FbmParams &params) {
+  fbm_batch<1>(points, results.begin(), results.size(), params, false);
+}
+void fbm(psl::span<const vec3> points, psl::span<float> results, const FbmParams &params) {
+  fbm_batch<1>(points, results.begin(), results.size(), params, false);
+}
+void fbm2d(psl::span<const vec2> points, psl::span<vec2> results, const FbmParams &params) {
+  fbm_batch<2>(points, &results.begin()->x, results.size(), params, false);
+}
+void fbm2d(psl::span<const vec3> points, psl::span<vec2> results, const FbmParams &params) {
+  fbm_batch<2>(points, &results.begin()->x, results.size(), params, false);
+}
+void fbm3d(psl::span<const vec2> points, psl::span<vec3> results, const FbmParams &params) {
+  fbm_batch<3>(points, &results.begin()->x, results.size(), params, false);
+}
+void fbm3d(psl::span<const vec3> points, psl::span<vec3> results, const FbmParams &params) {
+  fbm_batch<3>(points, &results.begin()->x, results.size(), params, false);
+}
+
+template <typename V>
+NoiseGrad<V> fbm_grad(V np, const FbmParams &params, bool raw) {
+  auto result = NoiseGrad<V>();
+  fbm_scalar<1>(np, params, &result.value, &result.gradient, raw);
+  return result;
+}
+NoiseGrad<vec2> perlin_noise_grad(vec2 np, int seed, PerlinGradients gradients) {
+  auto params = FbmParams{.octaves = 1, .seed = seed, .gradients = gradients};
+  return fbm_grad(np, params, true);
+}
+NoiseGrad<vec3> perlin_noise_grad(vec3 np, int seed, PerlinGradients gradients) {
+  auto params = FbmParams{.octaves = 1, .seed = seed, .gradients = gradients};
+  return fbm_grad(np, params, true);
+}
+NoiseGrad<vec2> fbm_grad(vec2 np, const FbmParams &params) {
+  return fbm_grad(np, params, false);
+}
+NoiseGrad<vec3> fbm_grad(vec3 np, const FbmParams &params) {
+  return fbm_grad(np, params, false);
+}
+
+void perlin_noise_grad(psl::span<const vec2> points, psl::span<float> values,
+                       psl::span<vec2> gradients, int seed, PerlinGradients lattice) {
+  CHECK_EQ(gradients.size(), values.size());
+  auto params = FbmParams{.octaves = 1, .seed = seed, .gradients = lattice};
+  fbm_batch<1>(points, values.begin(), values.size(), params, true, &gradients.begin()->x);
+}
+void perlin_noise_grad(psl::span<const vec3> points, psl::span<float> values,
+                       psl::span<vec3> gradients, int seed, PerlinGradients lattice) {
+  CHECK_EQ(gradients.size(), values.size());
+  auto params = FbmParams{.octaves = 1, .seed = seed, .gradients = lattice};
+  fbm_batch<1>(points, values.begin(), values.size(), params, true, &gradients.begin()->x);
+}
+void fbm_grad(psl::span<const vec2> points, psl::span<float> values, psl::span<vec2> gradients,
+              const FbmParams &params) {
+  CHECK_EQ(gradients.size(), values.size());
+  fbm_batch<1>(points, values.begin(), values.size(), params, false, &gradients.begin()->x);
+}
+void fbm_grad(psl::span<const vec3> points, psl::span<float> values, psl::span<vec3> gradients,
+              const FbmParams &params) {
+  CHECK_EQ(gradients.size(), values.size());
+  fbm_batch<1>(points, values.begin(), values.size(), params, false, &gradients.begin()->x);
+}
+
+float fractal_noise(vec2 np, const FractalParams &params) {
+  return fractal_scalar(np, params);
+}
+float fractal_noise(vec3 np, const FractalParams &params) {
+  return fractal_scalar(np, params);
+}
+void fractal_noise(psl::span<const vec2> points, psl::span<float> results,
+                   const FractalParams &params) {
+  fractal_batch(points, results, params);
+}
+void fractal_noise(psl::span<const vec3> points, psl::span<float> results,
+                   const FractalParams &params) {
+  fractal_batch(points, results, params);
+}
+
+float simplex_fbm(vec2 np, const FbmParams &params) {
+  return simplex_fbm<2>(&np[0], params);
+}
+float simplex_fbm(vec3 np, const FbmParams &params) {
+  return simplex_fbm<3>(&np[0], params);
+}
+float simplex_fbm(vec4 np, const FbmParams &params) {
+  return simplex_fbm<4>(&np[0], params);
+}
+
+void simplex_noise(psl::span<const vec2> points, psl::span<float> results, int seed) {
+  simplex_batch(points, results, FbmParams{.octaves = 1, .seed = seed}, true);
+}
+void simplex_noise(psl::span<const vec3> points, psl::span<float> results, int seed) {
+  simplex_batch(points, results, FbmParams{.octaves = 1, .seed = seed}, true);
+}
+void simplex_noise(psl::span<const vec4> points, psl::span<float> results, int seed) {
+  simplex_batch(points, results, FbmParams{.octaves = 1, .seed = seed}, true);
+}
+void simplex_fbm(psl::span<const vec2> points, psl::span<float> results, const FbmParams &params) {
+  simplex_batch(points, results, params, false);
+}
+void simplex_fbm(psl::span<const vec3> points, psl::span<float> results, const FbmParams &params) {
+  simplex_batch(points, results, params, false);
+}
+void simplex_fbm(psl::span<const vec4> points, psl::span<float> results, const FbmParams &params) {
+  simplex_batch(points, results, params, false);
+}
+
+namespace {
+
+// Baked tiles hold 4096 lattice samples: 64 x 64 in 2D, 16 x 16 x 16 in 3D
+template <int D>
+constexpr int baked_tile_size = D == 2 ? 64 : 16;
+template <int D>
+constexpr int baked_tile_samples = D == 2 ? 64 * 64 : 16 * 16 * 16;
+
+// The distance between neighbouring samples of a tile along axis a, in its x-major layout
+template <int D>
+constexpr int stride_of(int a) {
+  return a == 0 ? 1 : baked_tile_size<D> * stride_of<D>(a - 1);
+}
+
+// The tile holding lattice sample `i`, rounding toward negative infinity
+template <int D>
+int tile_of(int i) {
+  constexpr int size = baked_tile_size<D>;
+  return (i >= 0 ? i : i - size + 1) / size;
+}
+
+// Lattice corners and their gradients, stored by component
+template <int D>
+struct CornerList {
+  void resize(size_t n) {
+    this->n = n;
+    for (int a = 0; a < D; a++) {
+      coords[a].resize((n + 7) / 8 * 8);
+      g[a].resize((n + 7) / 8 * 8);
+    }
+  }
+
+  // Batches of 8 corners go through the kernels of the batch overloads where AVX2 is available
+  template <typename V, typename Vi>
+  void compute_gradients(int seed, PerlinGradients gradients) {
+#ifdef PSL_X86
+    if (psl::has_avx2_fma()) {
+      const int32_t *c[D];
+      float *out[D];
+      for (int a = 0; a < D; a++) {
+        c[a] = coords[a].data();
+        out[a] = g[a].data();
+      }
+      if (gradients == PerlinGradients::Table)
+        corner_gradients_avx2<D>(TableGradients<1>{{&perlin_table(seed)}}, c, out, n);
+      else
+        corner_gradients_avx2<D>(HashedGradients<1>{{seed}}, c, out, n);
+      return;
+    }
+#endif
+    for (size_t j = 0; j < n; j++) {
+      auto corner = Vi();
+      for (int a = 0; a < D; a++)
+        corner[a] = coords[a][j];
+      auto gradient = corner_gradient<V>(corner, seed, gradients);
+      for (int a = 0; a < D; a++)
+        g[a][j] = gradient[a];
+    }
+  }
+
+  size_t n = 0;
+  psl::vector<int32_t> coords[D];
+  psl::vector<float> g[D];
+};
+
+// One octave of a baked tile in the arithmetic of `fbm_scalar`, adding it to every sample of
+// `results`. `w[a]` and `offset[a]` hold the fade curve and lattice cell of each sample along
+// axis a, the cell relative to the first corner of `g`, which holds the gradients of the corners
+// by component; they're laid out with `stride` if `shared`, or 2^D per sample otherwise
+template <int D, typename V, int size>
+void bake_octave(const float (*w)[size], const int32_t (*offset)[size], const int *stride,
+                 bool shared, const float *const *g, float weight, float *results) {
+  constexpr int n = psl::powi(size, D);
+  int i[D] = {};
+  for (int s = 0; s < n; s++) {
+    // Corner weights and indices are built up axis by axis: bit D - 1 - a of a corner is its
+    // offset along axis a, and the weights multiply in the same order as in `fbm_scalar`
+    double cw[1 << D] = {1.0};
+    size_t j[1 << D] = {};
+    for (int a = 0; a < D; a++)
+      for (int k = (1 << a) - 1; k >= 0; k--)
+        for (int o = 1; o >= 0; o--) {
+          cw[k * 2 + o] = cw[k] * (o * w[a][i[a]] + (1 - o) * (1.0 - w[a][i[a]]));
+          j[k * 2 + o] = j[k] + (offset[a][i[a]] + o) * stride[a];
+        }
+    auto sum = 0.0f;
+    for (int k = 0; k < (1 << D); k++) {
+      auto index = shared ? j[k] : (size_t(s) << D) + k;
+      auto gradient = V(), delta = V();
+      for (int a = 0; a < D; a++) {
+        gradient[a] = g[a][index];
+        delta[a] = w[a][i[a]] - float((k >> (D - 1 - a)) & 1);
+      }
+      sum += cw[k] * dot(gradient, delta);
+    }
+    results[s] += weight * (0.5f * (1.0f + sum));
+    for (int a = 0; a < D && ++i[a] == size; a++)
+      i[a] = 0;
+  }
+}
+
+// The lattice cell `floor(p)` as an integer. Cells outside the range of int, where floats are
+// too coarse for the noise to mean anything, are clamped so that converting them and adding one
+// for the far corner stay defined
+inline int32_t lattice_cell(float cell) {
+  if (cell >= 2147483520.0f)
+    return 2147483520;
+  return cell > -2147483648.0f ? int32_t(cell) : -2147483647 - 1;
+}
+
+// `fbm` at every sample of one tile, stored x-major. The lattice coordinates and fade curves are
+// computed once per axis, and the gradient of each lattice corner the tile touches once per
+// octave instead of once per sample around it
+template <int D, typename V, typename Vi>
+void bake_tile(Vi tile, V spacing, const FbmParams &params, float *results) {
+  constexpr int size = baked_tile_size<D>, n = baked_tile_samples<D>;
+  float p[D][size];
+  for (int a = 0; a < D; a++)
+    for (int i = 0; i < size; i++)
+      p[a][i] = (float(int64_t(tile[a]) * size + i) + 0.5f) * spacing[a];
+
+  for (int s = 0; s < n; s++)
+    results[s] = 0.0f;
+  auto corners = CornerList<D>();
+  auto weight = 1.0f, total = 0.0f;
+  for (int octave = 0; octave < params.octaves; octave++) {
+    alignas(32) float w[D][size];
+    alignas(32) int32_t offset[D][size];
+    int32_t cell[D][size], lower[D];
+    int64_t extent[D];
+    for (int a = 0; a < D; a++) {
+      for (int i = 0; i < size; i++) {
+        auto c = psl::floor(p[a][i]);
+        w[a][i] = p[a][i] - c;
+        w[a][i] = w[a][i] * w[a][i] * (3 - 2 * w[a][i]);
+        cell[a][i] = lattice_cell(c);
+      }
+      lower[a] = psl::min(cell[a][0], cell[a][size - 1]);
+      extent[a] = int64_t(psl::max(cell[a][0], cell[a][size - 1])) - lower[a] + 2;
+    }
+
+    // Neighbouring samples share corners unless they're sparser than the lattice, in which case
+    // each sample gets its own 2^D corners. The extents are only multiplied while they're small,
+    // so a tile spread over a far wider range than int doesn't overflow the count
+    auto max_shared = size_t(n) << D;
+    auto n_corners = size_t(1);
+    auto shared = true;
+    for (int a = 0; a < D && shared; a++) {
+      shared = extent[a] <= int64_t(max_shared) && n_corners * extent[a] <= max_shared;
+      n_corners *= shared ? extent[a] : 1;
+    }
+    corners.resize(shared ? n_corners : max_shared);
+    int stride[D];
+    for (int a = 0; a < D; a++) {
+      stride[a] = !shared ? 0 : a == 0 ? 1 : stride[a - 1] * int(extent[a - 1]);
+      for (int i = 0; i < size; i++)
+        offset[a][i] = shared ? cell[a][i] - lower[a] : 0;
+    }
+    if (shared) {
+      int c[D] = {};
+      for (size_t j = 0; j < n_corners; j++) {
+        for (int a = 0; a < D; a++)
+          corners.coords[a][j] = lower[a] + c[a];
+        for (int a = 0; a < D && ++c[a] == extent[a]; a++)
+          c[a] = 0;
+      }
+    } else {
+      for (size_t j = 0; j < corners.n; j++)
+        for (int a = 0; a < D; a++) {
+          auto o = (int(j) >> (D - 1 - a)) & 1;
+          corners.coords[a][j] = cell[a][(j >> D) / stride_of<D>(a) % size] + o;
+        }
+    }
+    corners.template compute_gradients<V, Vi>(octave_seed(params, octave, 0), params.gradients);
+
+    const float *g[D];
+    for (int a = 0; a < D; a++)
+      g[a] = corners.g[a].data();
+#ifdef PSL_X86
+    if (psl::has_avx2_fma())
+      bake_octave_avx2<D, size>(w, offset, stride, shared, g, weight, results);
+    else
+#endif
+      bake_octave<D, V, size>(w, offset, stride, shared, g, weight, results);
+
+    total += weight;
+    weight *= params.gain;
+    for (int a = 0; a < D; a++)
+      for (int i = 0; i < size; i++)
+        p[a][i] *= params.lacunarity;
+  }
+  for (int s = 0; s < n; s++)
+    results[s] = psl::sqr(results[s] / total);
+}
+
+// Everything that determines the samples of a tile, with floats stored as their bits
+struct BakedTileKey {
+  int32_t dim;
+  int32_t octaves;
+  uint32_t lacunarity;
+  uint32_t gain;
+  int32_t seed;
+  int32_t octave_seed_step;
+  int32_t gradients;
+  uint32_t spacing[3];
+  int32_t tile[3];
+
+  bool operator==(const BakedTileKey &) const = default;
+};
+// The samples of a tile, shared by the cache and every thread copying from it. `baking` is 1
+// from the moment a thread claims the tile until it has baked it, and the samples are only
+// touched by that thread until then
+struct BakedTile {
+  psl::vector<float> samples;
+  JobCounter baking;
+};
+using BakedTilePtr = psl::atomic_shared_ptr<BakedTile>;
+
+// The most recently used baked tiles, shared by every `bake_noise` call. A lookup that misses
+// inserts the tile before it's baked, so threads that want it meanwhile wait on `baking` rather
+// than baking it again. Entries sit in a fixed array linked in LRU order, so hits and evictions
+// take constant time under a spin lock held for a few hundred nanoseconds; tiles stay alive
+// through their shared pointer while a thread copies or bakes one that has just been evicted
+class BakedTileCache {
+public:
+  BakedTileCache() : nodes(capacity + 1) {
+    nodes[sentinel].prev = nodes[sentinel].next = sentinel;
+  }
+
+  // The tile of `key`, and whether the caller claimed it and has to bake it
+  psl::pair<BakedTilePtr, bool> find_or_claim(const BakedTileKey &key) {
+    lock();
+    if (auto it = slots.find(key); it != slots.end()) {
+      auto i = it->second;
+      unlink(i);
+      push_front(i);
+      auto tile = nodes[i].tile;
+      unlock();
+      return {psl::move(tile), false};
+    }
+
+    uint32_t i;
+    if (n_used == capacity) {
+      i = nodes[sentinel].prev;
+      slots.erase(nodes[i].key);
+      unlink(i);
+    } else {
+      i = n_used++;
+    }
+    auto tile = psl::make_atomic_shared<BakedTile>();
+    tile->baking.value.store(1, psl::memory_order::relaxed);
+    nodes[i].key = key;
+    nodes[i].tile = tile;
+    slots.insert(key, i);
+    push_front(i);
+    unlock();
+    return {psl::move(tile), true};
+  }
+
+private:
+  // 1024 tiles of 4096 floats, 16 MB
+  static constexpr uint32_t capacity = 1024;
+  // The head and tail of the list, most recently used first
+  static constexpr uint32_t sentinel = capacity;
+
+  struct Node {
+    BakedTileKey key;
+    BakedTilePtr tile;
+    uint32_t prev = 0, next = 0;
+  };
+
+  void unlink(uint32_t i) {
+    nodes[nodes[i].prev].next = nodes[i].next;
+    nodes[nodes[i].next].prev = nodes[i].prev;
+  }
+  void push_front(uint32_t i) {
+    nodes[i].prev = sentinel;
+    nodes[i].next = nodes[sentinel].next;
+    nodes[nodes[sentinel].next].prev = i;
+    nodes[sentinel].next = i;
+  }
+
+  void lock() {
+    while (locked.exchange(true, psl::memory_order::acquire))
+      psl::cpu_relax();
+  }
+  void unlock() {
+    locked.store(false, psl::memory_order::release);
+  }
+
+  psl::vector<Node> nodes;
+  uint32_t n_used = 0;
+  psl::flat_hash_map<BakedTileKey, uint32_t> slots;
+  psl::atomic<bool> locked = false;
+};
+
+BakedTileCache &baked_tile_cache() {
+  static BakedTileCache cache;
+  return cache;
+}
+
+// Fill the array of `D` dimensions at `data`, x-major, from the tiles overlapping it, baking
+// the ones that aren't cached on the job system
+template <int D, typename V, typename Vi>
+void bake_noise(float *data, Vi array_size, Vi offset, V spacing, const FbmParams &params) {
+  constexpr int size = baked_tile_size<D>;
+  Vi first_tile, n_tiles;
+  auto total_tiles = int64_t(1);
+  for (int a = 0; a < D; a++) {
+    if (array_size[a] <= 0)
+      return;
+    first_tile[a] = tile_of<D>(offset[a]);
+    n_tiles[a] = tile_of<D>(offset[a] + array_size[a] - 1) - first_tile[a] + 1;
+    total_tiles *= n_tiles[a];
+  }
+
+  auto key = BakedTileKey{.dim = D,
+                          .octaves = params.octaves,
+                          .lacunarity = psl::bitcast<uint32_t>(params.lacunarity),
+                          .gain = psl::bitcast<uint32_t>(params.gain),
+                          .seed = params.seed,
+                          .octave_seed_step = params.octave_seed_step,
+                          .gradients = int32_t(params.gradients),
+                          .spacing = {},
+                          .tile = {}};
+  for (int a = 0; a < D; a++)
+    key.spacing[a] = psl::bitcast<uint32_t>(spacing[a]);
+
+  parallel_chunks(0, total_tiles, 1, [&](int64_t first, int64_t last) {
+    for (auto t = first; t < last; t++) {
+      auto tile = Vi(), lower = Vi(), upper = Vi();
+      auto tile_key = key;
+      for (int a = 0, rest = int(t); a < D; rest /= n_tiles[a], a++) {
+        tile[a] = first_tile[a] + rest % n_tiles[a];
+        tile_key.tile[a] = tile[a];
+        // The samples of this tile inside the array, relative to the array
+        lower[a] = psl::max(tile[a] * size - offset[a], 0);
+        upper[a] = psl::min(tile[a] * size + size - offset[a], array_size[a]);
+      }
+
+      auto [baked, claimed] = baked_tile_cache().find_or_claim(tile_key);
+      if (claimed) {
+        baked->samples.resize(baked_tile_samples<D>);
+        bake_tile<D>(tile, spacing, params, baked->samples.data());
+        baked->baking.value.store(0, psl::memory_order::release);
+      } else {
+        job_system().wait(baked->baking);
+      }
+
+      // Copy the runs along x, starting from the samples with `p[0] == lower[0]`
+      auto row_upper = upper;
+      row_upper[0] = lower[0] + 1;
+      auto row_bytes = size_t(upper[0] - lower[0]) * sizeof(float);
+      auto copy_row = [&](Vi p) {
+        auto src = size_t(0), dst = size_t(0);
+        for (int a = D - 1; a >= 0; a--) {
+          src = src * size + (p[a] + offset[a] - tile[a] * size);
+          dst = dst * array_size[a] + p[a];
+        }
+        psl::memcpy(data + dst, baked->samples.data() + src, row_bytes);
+      };
+      if constexpr (D == 2)
+        for_2d(lower, row_upper, copy_row);
+      else
+        for_3d(lower, row_upper, copy_row);
+    }
+  });
+}
+
+}  // namespace
+
+void bake_noise(Array2df &array, const NoiseRegion2d &region, const FbmParams &params) {
+  bake_noise<2>(array.data(), array.size(), region.offset, region.spacing, params);
+}
+void bake_noise(Array3df &array, const NoiseRegion3d &region, const FbmParams &params) {
+  bake_noise<3>(array.data(), vec3i(array.size()), region.offset, region.spacing, params);
+}
+
+}  // namespace pine
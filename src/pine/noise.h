@@ -1,5 +1,8 @@
 #pragma once
 #include <pine/vecmath.h>
+#include <pine/array.h>
+
+#include <psl/span.h>
 
 namespace pine {
 
@@ -13,6 +16,52 @@ vec3 perlin_noise3d(float p, int seed = 0);
 vec3 perlin_noise3d(vec2 p, int seed = 0);
 vec3 perlin_noise3d(vec3 p, int seed = 0);
 
+// Where `perlin_noise` gets the gradient of each lattice corner
+enum class PerlinGradients {
+  // Hashed from the corner and seed, as in the overloads without this argument
+  Hashed,
+  // Looked up in a 256-entry permutation table built once per seed, with gradients drawn from
+  // the same distributions; several times cheaper, but the field repeats every 256 units
+  Table
+};
+float perlin_noise(vec2 p, int seed, PerlinGradients gradients);
+float perlin_noise(vec3 p, int seed, PerlinGradients gradients);
+
+// `results[i] = perlin_noise(points[i], seed, gradients)`, 8 points at a time where AVX2 is
+// available. Hashed gradients are computed exactly but their trigonometry is polynomial, so
+// results agree with the scalar overloads to about 1e-6
+void perlin_noise(psl::span<const vec2> points, psl::span<float> results, int seed = 0,
+                  PerlinGradients gradients = PerlinGradients::Hashed);
+void perlin_noise(psl::span<const vec3> points, psl::span<float> results, int seed = 0,
+                  PerlinGradients gradients = PerlinGradients::Hashed);
+
+// Simplex noise in [0, 1], blending the gradients of the D + 1 corners of the simplex around `p`
+// rather than the 2^D corners of a cube, so its cost grows as D^2 instead of 2^D. Gradients come
+// from a fixed set indexed by a hash of the corner and seed, so the field doesn't repeat
+float simplex_noise(vec2 p, int seed = 0);
+float simplex_noise(vec3 p, int seed = 0);
+float simplex_noise(vec4 p, int seed = 0);
+
+// `results[i] = simplex_noise(points[i], seed)`, 8 points at a time where AVX2 is available. The
+// kernels take the scalar steps in the same order, so results are the same as the scalar
+// overloads' as long as the compiler doesn't contract them into fmas, which the build turns off;
+// with contraction they drift apart as the coordinates grow, by 2e-5 on 2D points in [-50, 50]
+void simplex_noise(psl::span<const vec2> points, psl::span<float> results, int seed = 0);
+void simplex_noise(psl::span<const vec3> points, psl::span<float> results, int seed = 0);
+void simplex_noise(psl::span<const vec4> points, psl::span<float> results, int seed = 0);
+
+// Parameters of the fused fbm, which evaluates every channel and octave in one pass over the
+// lattice; the defaults give the same field as the overloads taking `octaves`
+struct FbmParams {
+  int octaves = 8;
+  float lacunarity = 2.0f;
+  float gain = 0.5f;
+  // Channel c of octave i uses seed `seed + c + i * octave_seed_step`
+  int seed = 0;
+  int octave_seed_step = 0;
+  PerlinGradients gradients = PerlinGradients::Hashed;
+};
+
 float fbm(float p, int octaves);
 float fbm(vec2 p, int octaves);
 float fbm(vec3 p, int octaves);
@@ -23,4 +72,116 @@ vec3 fbm3d(float p, int octaves);
 vec3 fbm3d(vec2 p, int octaves);
 vec3 fbm3d(vec3 p, int octaves);
 
+float fbm(vec2 p, const FbmParams &params);
+float fbm(vec3 p, const FbmParams &params);
+vec2 fbm2d(vec2 p, const FbmParams &params);
+vec2 fbm2d(vec3 p, const FbmParams &params);
+vec3 fbm3d(vec2 p, const FbmParams &params);
+vec3 fbm3d(vec3 p, const FbmParams &params);
+
+// Fused fbm at every point, 8 points at a time where AVX2 is available; hashed gradients agree
+// with the scalar overloads to about 1e-6
+void fbm(psl::span<const vec2> points, psl::span<float> results, const FbmParams &params);
+void fbm(psl::span<const vec3> points, psl::span<float> results, const FbmParams &params);
+void fbm2d(psl::span<const vec2> points, psl::span<vec2> results, const FbmParams &params);
+void fbm2d(psl::span<const vec3> points, psl::span<vec2> results, const FbmParams &params);
+void fbm3d(psl::span<const vec2> points, psl::span<vec3> results, const FbmParams &params);
+void fbm3d(psl::span<const vec3> points, psl::span<vec3> results, const FbmParams &params);
+
+// A noise value along with its gradient with respect to the sample position
+template <typename V>
+struct NoiseGrad {
+  float value;
+  V gradient;
+};
+
+// `perlin_noise` and `fbm` together with their gradients, which are differentiated analytically
+// through the fade curves and corner weights, so a normal costs one evaluation rather than one
+// more per axis for finite differences. The values are the same as those of the plain overloads
+NoiseGrad<vec2> perlin_noise_grad(vec2 p, int seed = 0,
+                                  PerlinGradients gradients = PerlinGradients::Hashed);
+NoiseGrad<vec3> perlin_noise_grad(vec3 p, int seed = 0,
+                                  PerlinGradients gradients = PerlinGradients::Hashed);
+NoiseGrad<vec2> fbm_grad(vec2 p, const FbmParams &params);
+NoiseGrad<vec3> fbm_grad(vec3 p, const FbmParams &params);
+
+// The batch versions of the above, 8 points at a time where AVX2 is available; values agree with
+// the scalar overloads as the batch `perlin_noise` and `fbm` do
+void perlin_noise_grad(psl::span<const vec2> points, psl::span<float> values,
+                       psl::span<vec2> gradients, int seed = 0,
+                       PerlinGradients lattice = PerlinGradients::Hashed);
+void perlin_noise_grad(psl::span<const vec3> points, psl::span<float> values,
+                       psl::span<vec3> gradients, int seed = 0,
+                       PerlinGradients lattice = PerlinGradients::Hashed);
+void fbm_grad(psl::span<const vec2> points, psl::span<float> values, psl::span<vec2> gradients,
+              const FbmParams &params);
+void fbm_grad(psl::span<const vec3> points, psl::span<float> values, psl::span<vec3> gradients,
+              const FbmParams &params);
+
+// How `fractal_noise` shapes the Perlin signal s, in about [-1, 1], of each octave before summing
+enum class FractalShape {
+  // 0.5 * (1 + s), normalized and squared like `fbm`
+  Fbm,
+  // |s|, which folds the field into rounded lumps with creases along its zero crossings
+  Billow,
+  // Musgrave's ridged multifractal: (ridge_offset - |s|)^2, scaled by the previous octave's value
+  // times `ridge_gain` clamped to [0, 1], so that detail gathers along the sharp ridges
+  Ridged
+};
+
+// A noise stack: octaves of Perlin noise shaped by `shape`, optionally at a point displaced by a
+// domain warp. The warp is a D-channel fbm of `warp_octaves`, left unsquared and centered so that
+// `p` moves by up to `warp` along each axis
+struct FractalParams {
+  FractalShape shape = FractalShape::Fbm;
+  FbmParams octaves;
+  float ridge_offset = 1.0f;
+  float ridge_gain = 2.0f;
+  float warp = 0.0f;
+  // Seeded apart from the default `octaves` so the warp doesn't follow the field it warps
+  FbmParams warp_octaves = {.octaves = 4, .seed = 1};
+};
+
+// The stack at `p`, in [0, 1]. Every octave of the warp evaluates its D channels in one pass over
+// the lattice, and with the default `Fbm` shape and no warp this is `fbm(p, params.octaves)`
+float fractal_noise(vec2 p, const FractalParams &params);
+float fractal_noise(vec3 p, const FractalParams &params);
+
+// `fractal_noise` at every point, warp and octaves together 8 points at a time where AVX2 is
+// available; results agree with the scalar overloads to about 1e-6 times the warp's slope
+void fractal_noise(psl::span<const vec2> points, psl::span<float> results,
+                   const FractalParams &params);
+void fractal_noise(psl::span<const vec3> points, psl::span<float> results,
+                   const FractalParams &params);
+
+// Fbm over simplex noise instead of Perlin noise, normalized and squared like `fbm`;
+// `params.gradients` doesn't apply
+float simplex_fbm(vec2 p, const FbmParams &params);
+float simplex_fbm(vec3 p, const FbmParams &params);
+float simplex_fbm(vec4 p, const FbmParams &params);
+void simplex_fbm(psl::span<const vec2> points, psl::span<float> results, const FbmParams &params);
+void simplex_fbm(psl::span<const vec3> points, psl::span<float> results, const FbmParams &params);
+void simplex_fbm(psl::span<const vec4> points, psl::span<float> results, const FbmParams &params);
+
+// A window onto the lattice of noise samples at `(i + 0.5) * spacing` for integers i: element j
+// of a baked array is sample `offset + j`. These are the points `grid` spreads between
+// `offset * spacing` and `(offset + size) * spacing`, up to rounding
+struct NoiseRegion2d {
+  vec2i offset;
+  vec2 spacing = vec2(1.0f);
+};
+struct NoiseRegion3d {
+  vec3i offset;
+  vec3 spacing = vec3(1.0f);
+};
+
+// Fill `array` with `fbm(p, params)` at the samples of `region`; where AVX2 is available tiles
+// are interpolated 8 samples at a time and agree with `fbm` to about 1e-6, otherwise exactly.
+// The lattice is cut into fixed tiles of 4096 samples that are baked in parallel, each computing
+// the gradient of a lattice corner once per octave rather than once per sample around it. Tiles
+// are kept in a process-wide LRU cache keyed by the parameters, spacing and tile, so a window
+// that pans over an earlier one only bakes the tiles it hasn't seen
+void bake_noise(Array2df &array, const NoiseRegion2d &region, const FbmParams &params);
+void bake_noise(Array3df &array, const NoiseRegion3d &region, const FbmParams &params);
+
 }  // namespace pine
@@ -0,0 +1,260 @@
+#include <pine/parallel.h>
+#include <pine/log.h>
+
+#include <psl/concurrent_queue.h>
+#include <psl/pool.h>
+#include <psl/limits.h>
+
+namespace pine {
+
+struct JobSystem::Job {
+  psl::function<void()> fn;
+  JobCounter* counter;
+};
+
+namespace {
+
+// Chase-Lev deque of fixed capacity (Lê et al., "Correct and Efficient Work-Stealing for Weak
+// Memory Models"). Only the owner calls `push` and `pop`; anyone may `steal`
+class WorkStealingDeque {
+public:
+  static constexpr int64_t capacity = 4096;
+
+  bool push(JobSystem::Job* job) {
+    auto b = bottom.load(psl::memory_order::relaxed);
+    auto t = top.load(psl::memory_order::acquire);
+    if (b - t >= capacity)
+      return false;
+    psl::atomic_store(&jobs[b & (capacity - 1)], job, psl::memory_order::relaxed);
+    // Publishes the job to thieves, who load `bottom` with acquire
+    bottom.store(b + 1, psl::memory_order::release);
+    return true;
+  }
+  JobSystem::Job* pop() {
+    auto b = bottom.load(psl::memory_order::relaxed) - 1;
+    bottom.store(b, psl::memory_order::relaxed);
+    psl::atomic_thread_fence(psl::memory_order::seq_cst);
+    auto t = top.load(psl::memory_order::relaxed);
+    if (t > b) {
+      bottom.store(b + 1, psl::memory_order::relaxed);
+      return nullptr;
+    }
+    auto job = psl::atomic_load(&jobs[b & (capacity - 1)], psl::memory_order::relaxed);
+    if (t == b) {
+      // The last job; race the thieves for it
+      if (!top.compare_exchange_strong(t, t + 1, psl::memory_order::seq_cst,
+                                       psl::memory_order::relaxed))
+        job = nullptr;
+      bottom.store(b + 1, psl::memory_order::relaxed);
+    }
+    return job;
+  }
+  JobSystem::Job* steal() {
+    auto t = top.load(psl::memory_order::acquire);
+    psl::atomic_thread_fence(psl::memory_order::seq_cst);
+    auto b = bottom.load(psl::memory_order::acquire);
+    if (t >= b)
+      return nullptr;
+    auto job = psl::atomic_load(&jobs[t & (capacity - 1)], psl::memory_order::relaxed);
+    if (!top.compare_exchange_strong(t, t + 1, psl::memory_order::seq_cst,
+                                     psl::memory_order::relaxed))
+      return nullptr;
+    return job;
+  }
+
+private:
+  alignas(psl::cache_line_size) psl::atomic<int64_t> top = 0;
+  alignas(psl::cache_line_size) psl::atomic<int64_t> bottom = 0;
+  alignas(psl::cache_line_size) JobSystem::Job* jobs[capacity];
+};
+
+// The worker index of the calling thread, or -1 for threads the job system didn't start
+thread_local int this_worker = -1;
+thread_local JobSystem* this_system = nullptr;
+
+}  // namespace
+
+struct JobSystem::Worker {
+  WorkStealingDeque deque;
+  psl::thread thread;
+};
+
+struct JobSystem::Shared {
+  // Jobs from threads that don't own a deque
+  psl::mpmc_queue<Job*> injected{4096};
+  // Idle workers sleep on `epoch`, which is bumped whenever there's new work and a sleeper
+  alignas(psl::cache_line_size) psl::atomic<int> epoch = 0;
+  psl::atomic<int> sleepers = 0;
+  psl::atomic<bool> quit = false;
+};
+
+JobSystem::JobSystem(int n_threads) {
+  n_workers = psl::max(n_threads, 1) - 1;
+  shared = new Shared;
+  workers = new Worker[n_workers];
+  for (int i = 0; i < n_workers; i++)
+    workers[i].thread = psl::thread([this, i]() { worker_main(i); });
+}
+JobSystem::~JobSystem() {
+  shared->quit.store(true);
+  shared->epoch.fetch_add(1);
+  shared->epoch.notify_all();
+  for (int i = 0; i < n_workers; i++)
+    workers[i].thread.join();
+  delete[] workers;
+  delete shared;
+}
+
+void JobSystem::run(psl::function<void()> fn, JobCounter* counter) {
+  if (counter)
+    counter->value.fetch_add(1, psl::memory_order::relaxed);
+  auto job = (Job*)psl::pool_alloc(sizeof(Job));
+  psl::construct_at(job, Job{psl::move(fn), counter});
+
+  auto pushed = this_system == this ? workers[this_worker].deque.push(job)
+                                    : shared->injected.try_push(job);
+  if (!pushed) {
+    // Out of room, which only happens with thousands of jobs queued; running it here keeps going
+    execute(job);
+    return;
+  }
+  wake_workers();
+}
+
+void JobSystem::wait(JobCounter& counter) {
+  auto self = this_system == this ? this_worker : -1;
+  for (int spins = 0; counter.value.load(psl::memory_order::acquire) > 0;) {
+    if (auto job = find_job(self)) {
+      execute(job);
+      spins = 0;
+    } else if (++spins > 64) {
+      psl::this_thread_yield();
+    } else {
+      psl::cpu_relax();
+    }
+  }
+}
+
+JobSystem::Job* JobSystem::find_job(int self) {
+  if (self >= 0)
+    if (auto job = workers[self].deque.pop())
+      return job;
+  if (auto job = shared->injected.try_pop())
+    return *job;
+  // Start stealing at a different victim on each thread to spread out contention
+  auto start = self >= 0 ? self + 1 : 0;
+  for (int i = 0; i < n_workers; i++) {
+    auto victim = (start + i) % n_workers;
+    if (victim != self)
+      if (auto job = workers[victim].deque.steal())
+        return job;
+  }
+  return nullptr;
+}
+
+void JobSystem::execute(Job* job) {
+  job->fn();
+  if (job->counter)
+    job->counter->value.fetch_sub(1, psl::memory_order::release);
+  psl::destruct_at(job);
+  psl::pool_free(job);
+}
+
+void JobSystem::wake_workers() {
+  psl::atomic_thread_fence(psl::memory_order::seq_cst);
+  if (shared->sleepers.load(psl::memory_order::seq_cst) > 0) {
+    shared->epoch.fetch_add(1);
+    shared->epoch.notify_all();
+  }
+}
+
+void JobSystem::worker_main(int index) {
+  this_worker = index;
+  this_system = this;
+  auto spins = 0;
+  while (!shared->quit.load(psl::memory_order::relaxed)) {
+    if (auto job = find_job(index)) {
+      execute(job);
+      spins = 0;
+      continue;
+    }
+    if (++spins < 256) {
+      if (spins > 64)
+        psl::this_thread_yield();
+      else
+        psl::cpu_relax();
+      continue;
+    }
+
+    // Announce the intent to sleep before the last look for work, so that a `run` after that
+    // look sees the sleeper and bumps the epoch
+    auto epoch = shared->epoch.load();
+    shared->sleepers.fetch_add(1);
+    if (auto job = find_job(index)) {
+      shared->sleepers.fetch_sub(1);
+      execute(job);
+    } else {
+      if (!shared->quit.load())
+        shared->epoch.wait(epoch);
+      shared->sleepers.fetch_sub(1);
+    }
+    spins = 0;
+  }
+}
+
+JobSystem& job_system() {
+  static JobSystem system;
+  return system;
+}
+
+void JobSystem::parallel_chunks(int64_t lower, int64_t upper, int64_t grain,
+                                psl::function_ref<void(int64_t, int64_t)> body) {
+  if (upper <= lower)
+    return;
+  if (grain <= 0)
+    grain = psl::max((upper - lower) / (n_threads() * 8), int64_t(1));
+  if (upper - lower <= grain || n_threads() == 1) {
+    body(lower, upper);
+    return;
+  }
+
+  // Hand the upper half of the range to the pool and keep splitting the lower half, so idle
+  // threads steal the largest pieces first
+  auto counter = JobCounter();
+  struct Splitter {
+    void operator()(int64_t first, int64_t last) const {
+      while (last - first > grain) {
+        auto mid = first + (last - first) / 2;
+        system->run([*this, mid, last]() { (*this)(mid, last); }, counter);
+        last = mid;
+      }
+      (*body)(first, last);
+    }
+
+    JobSystem* system;
+    JobCounter* counter;
+    psl::function_ref<void(int64_t, int64_t)>* body;
+    int64_t grain;
+  };
+  Splitter{this, &counter, &body, grain}(lower, upper);
+  wait(counter);
+}
+void parallel_chunks(int64_t lower, int64_t upper, int64_t grain,
+                     psl::function_ref<void(int64_t, int64_t)> body) {
+  job_system().parallel_chunks(lower, upper, grain, body);
+}
+void parallel_chunks(int64_t lower, int64_t upper, int64_t grain, RNG& rng,
+                     psl::function_ref<void(int64_t, int64_t, RNG&)> body) {
+  CHECK_GT(grain, 0);
+  if (upper <= lower)
+    return;
+  auto n_chunks = (upper - lower + grain - 1) / grain;
+  CHECK_LE(n_chunks, psl::numeric_limits<int32_t>::max());
+  auto streams = rng.split(n_chunks);
+  parallel_chunks(0, n_chunks, 1, [&](int64_t first, int64_t last) {
+    for (auto i = first; i < last; i++)
+      body(lower + i * grain, psl::min(lower + (i + 1) * grain, upper), streams[i]);
+  });
+}
+
+}  // namespace pine
@@ -0,0 +1,130 @@
+#pragma once
+#include <pine/vecmath.h>
+#include <pine/rng.h>
+
+#include <psl/function.h>
+#include <psl/thread.h>
+
+namespace pine {
+
+// Counts the jobs that are still running; `JobSystem::wait` on it expresses a dependency
+struct JobCounter {
+  psl::atomic<int> value = 0;
+};
+
+// A work-stealing thread pool.
+// Every worker owns a Chase-Lev deque: it pushes and pops jobs at the bottom while idle workers
+// steal from the top, so a job that splits itself keeps its halves local until someone is idle.
+// Threads that aren't workers submit through a shared queue. `wait` runs other jobs until its
+// counter drops to zero, so jobs can wait on each other without tying up a thread
+class JobSystem {
+public:
+  // `n_threads` includes the thread that calls `wait`, so `n_threads - 1` workers are started
+  explicit JobSystem(int n_threads = psl::thread::hardware_concurrency());
+  ~JobSystem();
+  JobSystem(const JobSystem&) = delete;
+  JobSystem& operator=(const JobSystem&) = delete;
+
+  // Run `job` on some thread; `counter`, if any, is incremented now and decremented once it's done
+  void run(psl::function<void()> job, JobCounter* counter = nullptr);
+  void wait(JobCounter& counter);
+
+  // Call `body(first, last)` on subranges of [lower, upper) in parallel and wait for all of them.
+  // Subranges have at most `grain` elements, or there are about 8 per thread when `grain` is 0
+  void parallel_chunks(int64_t lower, int64_t upper, int64_t grain,
+                       psl::function_ref<void(int64_t, int64_t)> body);
+
+  int n_threads() const {
+    return n_workers + 1;
+  }
+
+  struct Job;
+  struct Worker;
+
+private:
+  Job* find_job(int self);
+  void execute(Job* job);
+  void worker_main(int index);
+  void wake_workers();
+
+  Worker* workers;
+  int n_workers;
+  struct Shared;
+  Shared* shared;
+};
+
+// The process-wide job system, started on first use with one thread per core
+JobSystem& job_system();
+
+// Tags for functions that can either run on the calling thread or on the job system
+namespace execution {
+struct Sequenced {};
+struct Parallel {};
+inline constexpr Sequenced seq;
+inline constexpr Parallel par;
+}  // namespace execution
+template <typename T>
+concept ExecutionPolicy =
+    psl::same_as<T, execution::Sequenced> || psl::same_as<T, execution::Parallel>;
+
+// `JobSystem::parallel_chunks` on the process-wide job system
+void parallel_chunks(int64_t lower, int64_t upper, int64_t grain,
+                     psl::function_ref<void(int64_t, int64_t)> body);
+
+// `parallel_chunks` over chunks of exactly `grain` elements but the last, where chunk i gets stream
+// i of `rng.split(n_chunks)`. The streams follow the chunks rather than the threads that run them,
+// so the results are the same for any number of threads, but `grain` is part of the output: the
+// same `rng` with another `grain` hands different streams to the elements. The streams are made
+// up front, one `jump` each on the calling thread, so `grain` should keep the chunks well above
+// the cost of about 128 draws each, and there can be no more than 2^31 - 1 of them
+void parallel_chunks(int64_t lower, int64_t upper, int64_t grain, RNG& rng,
+                     psl::function_ref<void(int64_t, int64_t, RNG&)> body);
+
+template <typename F>
+void parallel_for(int lower, int upper, F f) {
+  parallel_chunks(lower, upper, 0, [&](int64_t first, int64_t last) {
+    for (auto i = first; i < last; i++)
+      f(int(i));
+  });
+}
+template <typename F>
+void parallel_for(int size, F f) {
+  parallel_for(0, size, f);
+}
+
+// Same iteration space as `for_2d`, split into bands of whole rows
+template <typename F>
+void parallel_for_2d(vec2i lower, vec2i upper, F f) {
+  parallel_chunks(lower[1], upper[1], 0, [&](int64_t first, int64_t last) {
+    for (auto y = int(first); y < int(last); y++)
+      for (int x = lower[0]; x < upper[0]; x++)
+        f(vec2i(x, y));
+  });
+}
+template <typename F>
+void parallel_for_2d(vec2i size, F f) {
+  parallel_for_2d(vec2i(), size, f);
+}
+
+// Same iteration space as `for_3d`, split into runs of whole rows
+template <typename F>
+void parallel_for_3d(vec3i lower, vec3i upper, F f) {
+  auto rows_per_slice = int64_t(upper[1] - lower[1]);
+  auto n_rows = rows_per_slice * (upper[2] - lower[2]);
+  if (n_rows <= 0)
+    return;
+  parallel_chunks(0, n_rows, 0, [&](int64_t first, int64_t last) {
+    for (auto row = first; row < last; row++) {
+      auto y = lower[1] + int(row % rows_per_slice);
+      auto z = lower[2] + int(row / rows_per_slice);
+      for (int x = lower[0]; x < upper[0]; x++)
+        f(vec3i(x, y, z));
+    }
+  });
+}
+template <typename F>
+void parallel_for_3d(vec3i size, F f) {
+  parallel_for_3d(vec3i(), size, f);
+}
+
+}  // namespace pine
@@ -0,0 +1,189 @@
+#include <pine/rng.h>
+#include <pine/rng_avx2.h>
+
+#include <psl/cpu.h>
+
+namespace pine {
+
+namespace {
+
+// Lane k of a block of M-component values, as `RNG::nextf` and friends would give it
+template <int M>
+void fill_scalar(uint64_t *s0, uint64_t *s1, int n_lanes, float *out, size_t n_blocks,
+                 size_t n_values) {
+  for (int k = 0; k < n_lanes; k++) {
+    auto rng = RNG();
+    rng.s[0] = s0[k];
+    rng.s[1] = s1[k];
+    for (size_t i = 0; i < n_blocks; i++)
+      for (int c = 0; c < M; c++) {
+        auto x = rng.nextf();
+        auto index = (i * n_lanes + k) * M + c;
+        if (index < n_values)
+          out[index] = x;
+      }
+    s0[k] = rng.s[0];
+    s1[k] = rng.s[1];
+  }
+}
+
+}  // namespace
+
+#ifdef PSL_X86
+namespace {
+
+// One row of 8 interleaved x, y, z values: every component is gathered from `lanes` and the ones
+// at the positions set in `y_positions` and `z_positions` are kept from y and z
+template <int y_positions, int z_positions>
+PSL_AVX2 inline __m256 interleave_row(const __m256 *v, __m256i lanes) {
+  auto x = _mm256_permutevar8x32_ps(v[0], lanes);
+  auto y = _mm256_permutevar8x32_ps(v[1], lanes);
+  auto z = _mm256_permutevar8x32_ps(v[2], lanes);
+  return _mm256_blend_ps(_mm256_blend_ps(x, y, y_positions), z, z_positions);
+}
+
+// Write the M components of 8 lanes' values, `v[c]` holding component c, to `out` as 8 values
+template <int M>
+PSL_AVX2 inline void store_lanes(const __m256 *v, float *out) {
+  if constexpr (M == 1) {
+    _mm256_storeu_ps(out, v[0]);
+  } else if constexpr (M == 2) {
+    auto lo = _mm256_unpacklo_ps(v[0], v[1]);
+    auto hi = _mm256_unpackhi_ps(v[0], v[1]);
+    _mm256_storeu_ps(out, _mm256_permute2f128_ps(lo, hi, 0x20));
+    _mm256_storeu_ps(out + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+  } else {
+    // Row 0 is x0 y0 z0 x1 y1 z1 x2 y2, and so on
+    auto row0 = interleave_row<0x92, 0x24>(v, _mm256_setr_epi32(0, 0, 0, 1, 1, 1, 2, 2));
+    auto row1 = interleave_row<0x24, 0x49>(v, _mm256_setr_epi32(2, 3, 3, 3, 4, 4, 4, 5));
+    auto row2 = interleave_row<0x49, 0x92>(v, _mm256_setr_epi32(5, 5, 6, 6, 6, 7, 7, 7));
+    _mm256_storeu_ps(out, row0);
+    _mm256_storeu_ps(out + 8, row1);
+    _mm256_storeu_ps(out + 16, row2);
+  }
+}
+
+// The folded outputs of two sets of 4 lanes, in lane order
+PSL_AVX2 inline __m256i fold_avx2(__m256i lo, __m256i hi) {
+  return _mm256_set_m128i(fold32(hi), fold32(lo));
+}
+
+// `fill_scalar` over whole blocks, the state of each group of 8 lanes held in registers
+template <int N, int M>
+PSL_AVX2 void fill_avx2(uint64_t *s0, uint64_t *s1, float *out, size_t n_blocks) {
+  constexpr int G = N / 8;
+  __m256i a[G][2], b[G][2];
+  for (int g = 0; g < G; g++)
+    for (int h = 0; h < 2; h++) {
+      a[g][h] = _mm256_load_si256((const __m256i *)(s0 + g * 8 + h * 4));
+      b[g][h] = _mm256_load_si256((const __m256i *)(s1 + g * 8 + h * 4));
+    }
+  for (size_t i = 0; i < n_blocks; i++)
+    for (int g = 0; g < G; g++) {
+      __m256 v[M];
+      for (int c = 0; c < M; c++) {
+        auto lo = rng_next64u(a[g][0], b[g][0]);
+        auto hi = rng_next64u(a[g][1], b[g][1]);
+        v[c] = to_unit_float(fold_avx2(lo, hi));
+      }
+      store_lanes<M>(v, out + (i * N + g * 8) * M);
+    }
+  for (int g = 0; g < G; g++)
+    for (int h = 0; h < 2; h++) {
+      _mm256_store_si256((__m256i *)(s0 + g * 8 + h * 4), a[g][h]);
+      _mm256_store_si256((__m256i *)(s1 + g * 8 + h * 4), b[g][h]);
+    }
+}
+
+// Same as `fill_avx2` with a group's state in one register each and native rotates. GCC 12 warns
+// about the undefined passthrough of the unmasked shifts, so they are masked with every lane
+constexpr __mmask8 all_lanes = 0xff;
+template <int N, int M>
+PSL_AVX512 void fill_avx512(uint64_t *s0, uint64_t *s1, float *out, size_t n_blocks) {
+  constexpr int G = N / 8;
+  __m512i a[G], b[G];
+  for (int g = 0; g < G; g++) {
+    a[g] = _mm512_load_si512(s0 + g * 8);
+    b[g] = _mm512_load_si512(s1 + g * 8);
+  }
+  for (size_t i = 0; i < n_blocks; i++)
+    for (int g = 0; g < G; g++) {
+      __m256 v[M];
+      for (int c = 0; c < M; c++) {
+        auto result = _mm512_add_epi64(a[g], b[g]);
+        b[g] = _mm512_xor_si512(b[g], a[g]);
+        a[g] = _mm512_ternarylogic_epi64(_mm512_maskz_rol_epi64(all_lanes, a[g], 24), b[g],
+                                         _mm512_maskz_slli_epi64(all_lanes, b[g], 16), 0x96);
+        b[g] = _mm512_maskz_rol_epi64(all_lanes, b[g], 37);
+        result = _mm512_xor_si512(result, _mm512_maskz_srli_epi64(all_lanes, result, 32));
+        auto u = _mm512_maskz_cvtepi64_epi32(all_lanes, result);
+        v[c] = _mm256_min_ps(_mm256_mul_ps(_mm256_cvtepu32_ps(u), _mm256_set1_ps(0x1p-32f)),
+                             _mm256_set1_ps(one_minus_epsilon));
+      }
+      store_lanes<M>(v, out + (i * N + g * 8) * M);
+    }
+  for (int g = 0; g < G; g++) {
+    _mm512_store_si512(s0 + g * 8, a[g]);
+    _mm512_store_si512(s1 + g * 8, b[g]);
+  }
+}
+
+}  // namespace
+#endif
+
+namespace {
+
+template <int N, int M>
+void fill(uint64_t *s0, uint64_t *s1, float *out, size_t n_values) {
+  auto n_blocks = n_values / (N * M);
+#ifdef PSL_X86
+  if (psl::has_avx512())
+    fill_avx512<N, M>(s0, s1, out, n_blocks);
+  else if (psl::has_avx2_fma())
+    fill_avx2<N, M>(s0, s1, out, n_blocks);
+  else
+    n_blocks = 0;
+#else
+  n_blocks = 0;
+#endif
+  // Whatever the vector kernels didn't cover, including a partial block
+  auto done = n_blocks * N * M;
+  fill_scalar<M>(s0, s1, N, out + done, (n_values - done + N * M - 1) / (N * M),
+                 n_values - done);
+}
+
+}  // namespace
+
+template <int N>
+RNGxN<N>::RNGxN(uint64_t seed) {
+  auto streams = RNG(seed).split(N);
+  for (int k = 0; k < N; k++)
+    set_lane(k, streams[k]);
+}
+
+template <int N>
+void RNGxN<N>::nextf(psl::span<float> out) {
+  fill<N, 1>(s0, s1, out.begin(), out.size());
+}
+template <int N>
+void RNGxN<N>::next2f(psl::span<vec2> out) {
+  fill<N, 2>(s0, s1, (float *)out.begin(), out.size() * 2);
+}
+template <int N>
+void RNGxN<N>::next3f(psl::span<vec3> out) {
+  fill<N, 3>(s0, s1, (float *)out.begin(), out.size() * 3);
+}
+
+template <int N>
+void RNGxN<N>::jump() {
+  auto rng = lane(N - 1);
+  rng.jump();
+  auto streams = rng.split(N);
+  for (int k = 0; k < N; k++)
+    set_lane(k, streams[k]);
+}
+
+template struct RNGxN<8>;
+template struct RNGxN<16>;
+
+}  // namespace pine
@@ -3,46 +3,14 @@
 #include <pine/vecmath.h>
 
 #include <psl/memory.h>
+#include <psl/hash.h>
+#include <psl/vector.h>
+#include <psl/span.h>
 
 namespace pine {
 
-inline uint64_t murmur_hash64A(const unsigned char *key, size_t len, uint64_t seed) {
-  const uint64_t m = 0xc6a4a7935bd1e995ull;
-  const int r = 47;
-
-  uint64_t h = seed ^ (len * m);
-
-  const unsigned char *end = key + 8 * (len / 8);
-
-  while (key != end) {
-    uint64_t k;
-    psl::memcpy(&k, key, sizeof(uint64_t));
-    key += 8;
-
-    k *= m;
-    k ^= k >> r;
-    k *= m;
-
-    h ^= k;
-    h *= m;
-  }
-
-  switch (len & 7) {
-    case 7: h ^= uint64_t(key[6]) << 48; [[fallthrough]];
-    case 6: h ^= uint64_t(key[5]) << 40; [[fallthrough]];
-    case 5: h ^= uint64_t(key[4]) << 32; [[fallthrough]];
-    case 4: h ^= uint64_t(key[3]) << 24; [[fallthrough]];
-    case 3: h ^= uint64_t(key[2]) << 16; [[fallthrough]];
-    case 2: h ^= uint64_t(key[1]) << 8; [[fallthrough]];
-    case 1: h ^= uint64_t(key[0]); h *= m;
-  };
-
-  h ^= h >> r;
-  h *= m;
-  h ^= h >> r;
-
-  return h;
-}
+using psl::murmur_hash64A;
+using psl::mix_bits;
 
 template <typename T>
 inline uint64_t hash_buffer(const T *ptr, size_t size, uint64_t seed = 0) {
@@ -78,15 +46,6 @@ inline uint64_t split_mix_64(uint64_t &s) {
   return r ^ (r >> 31);
 }
 
-inline uint64_t mix_bits(uint64_t v) {
-  v ^= (v >> 31);
-  v *= 0x7fb5d329728ea185;
-  v ^= (v >> 27);
-  v *= 0x81dadef4bc2dd44d;
-  v ^= (v >> 33);
-  return v;
-}
-
 inline uint32_t rotl32(uint32_t x, int k) {
   return (x << k) | (x >> (32 - k));
 }
@@ -140,7 +99,83 @@ struct RNG {
     return {nextf(), nextf(), nextf()};
   }
 
+  // Advance by 2^64 values in about as long as 128 calls to `next64u` take
+  void jump() {
+    jump_polynomial(0xdf900294d8f554a5, 0x170865df4b3201fc);
+  }
+  // Advance by 2^96 values, 2^32 `jump`s; one level up from `jump` for handing out whole sets of
+  // streams, one per subsystem say, that each `split` further
+  void long_jump() {
+    jump_polynomial(0xd2a98b26625eee7b, 0xdddf9b1090aa7ac1);
+  }
+
+  // `n` streams that don't overlap for 2^64 values: stream i starts i `jump`s ahead of this one,
+  // which then moves past all of them. They only depend on the state and `n`, so handing them out
+  // by work item rather than by thread keeps parallel results the same on any number of threads.
+  // Each stream costs one `jump`, made one after another
+  psl::vector<RNG> split(int64_t n) {
+    auto streams = psl::vector<RNG>(n);
+    for (auto &stream : streams) {
+      stream = *this;
+      jump();
+    }
+    return streams;
+  }
+
+  // Replace the state with the sum of the states `polynomial`'s set bits select along the way,
+  // which is the state the polynomial's power of the transition leads to
+  void jump_polynomial(uint64_t low, uint64_t high) {
+    uint64_t polynomial[] = {low, high};
+    uint64_t s0 = 0, s1 = 0;
+    for (auto word : polynomial)
+      for (int b = 0; b < 64; b++) {
+        if (word & (uint64_t(1) << b)) {
+          s0 ^= s[0];
+          s1 ^= s[1];
+        }
+        next64u();
+      }
+    s[0] = s0;
+    s[1] = s1;
+  }
+
   uint64_t s[2];
 };
 
+// `N` xoroshiro128+ streams stored lane by lane and advanced together, with AVX2 or AVX-512 where
+// the CPU has them. Lane k gives exactly what `lane(k)` would, and the lanes start as
+// `RNG(seed).split(N)`, so none of them overlap for 2^64 values.
+// The span functions fill their output a block of N at a time, element `i * N + k` coming from
+// lane k; every lane advances once per block, also for the last one if it's partial
+template <int N>
+struct RNGxN {
+  static_assert(N % 8 == 0, "RNGxN works on groups of 8 lanes");
+
+  explicit RNGxN(uint64_t seed = 0);
+
+  void nextf(psl::span<float> out);
+  void next2f(psl::span<vec2> out);
+  void next3f(psl::span<vec3> out);
+
+  // Move every lane past all of the current ones, N jumps ahead, so that successive jumps hand
+  // out disjoint sets of streams, one per thread say
+  void jump();
+
+  RNG lane(int k) const {
+    auto rng = RNG();
+    rng.s[0] = s0[k];
+    rng.s[1] = s1[k];
+    return rng;
+  }
+  void set_lane(int k, RNG rng) {
+    s0[k] = rng.s[0];
+    s1[k] = rng.s[1];
+  }
+
+  alignas(64) uint64_t s0[N];
+  alignas(64) uint64_t s1[N];
+};
+using RNGx8 = RNGxN<8>;
+using RNGx16 = RNGxN<16>;
+
 }  // namespace pine
@@ -0,0 +1,46 @@
+#pragma once
+#include <pine/rng.h>
+
+#include <psl/cpu.h>
+
+// The AVX2 building blocks of `RNG` shared by the vectorized code in rng.cpp and noise.cpp; they
+// give bit for bit what the scalar `RNG` does, lane by lane, and may only be called from kernels
+// that are dispatched on `psl::has_avx2_fma`
+
+#ifdef PSL_X86
+namespace pine {
+
+template <int shift>
+PSL_AVX2 inline __m256i rotl64(__m256i x) {
+  return _mm256_or_si256(_mm256_slli_epi64(x, shift), _mm256_srli_epi64(x, 64 - shift));
+}
+
+// `RNG::next64u` of 4 lanes whose states are held in `s0` and `s1`
+PSL_AVX2 inline __m256i rng_next64u(__m256i &s0, __m256i &s1) {
+  auto result = _mm256_add_epi64(s0, s1);
+  s1 = _mm256_xor_si256(s1, s0);
+  s0 = _mm256_xor_si256(_mm256_xor_si256(rotl64<24>(s0), s1), _mm256_slli_epi64(s1, 16));
+  s1 = rotl64<37>(s1);
+  return result;
+}
+
+// `uint32_t(x ^ (x >> 32))` of each lane, as `RNG::nextf` folds its output, packed in lane order
+// into the low 128 bits
+PSL_AVX2 inline __m128i fold32(__m256i x) {
+  x = _mm256_xor_si256(x, _mm256_srli_epi64(x, 32));
+  x = _mm256_permutevar8x32_epi32(x, _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7));
+  return _mm256_castsi256_si128(x);
+}
+
+// `min(u * 0x1p-32f, one_minus_epsilon)` of 8 folded outputs: the uint32 is split in halves that
+// convert exactly, so the single rounding of the fma matches the scalar unsigned conversion
+PSL_AVX2 inline __m256 to_unit_float(__m256i u) {
+  auto hi = _mm256_cvtepi32_ps(_mm256_srli_epi32(u, 16));
+  auto lo = _mm256_cvtepi32_ps(_mm256_and_si256(u, _mm256_set1_epi32(0xffff)));
+  auto x = _mm256_fmadd_ps(hi, _mm256_set1_ps(65536.0f), lo);
+  return _mm256_min_ps(_mm256_mul_ps(x, _mm256_set1_ps(0x1p-32f)),
+                       _mm256_set1_ps(one_minus_epsilon));
+}
+
+}  // namespace pine
+#endif
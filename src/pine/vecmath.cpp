@@ -128,4 +128,26 @@ mat4 inverse(const mat4& m) {
   return r / det;
 }
 
+static uint8_t gamma_encode_exact(uint32_t bits) {
+  return uint8_t(psl::min(psl::pow(psl::bitcast<float>(bits), 1 / 2.2f) * 256, 255.0f));
+}
+// Built from the expression it replaces, so that the two agree on every input
+GammaEncodeLut::GammaEncodeLut() {
+  for (int i = 0; i < size; i++) {
+    auto range_first = first + (uint32_t(i) << 16);
+    auto base = gamma_encode_exact(range_first);
+    // The lowest bits in this range whose output is past `base`
+    auto lo = uint32_t(0), hi = uint32_t(0x10000);
+    while (lo < hi) {
+      auto mid = (lo + hi) / 2;
+      if (gamma_encode_exact(range_first + mid) > base)
+        hi = mid;
+      else
+        lo = mid + 1;
+    }
+    entries[i] = uint32_t(base) << 24 | lo;
+  }
+}
+const GammaEncodeLut gamma_encode_lut;
+
 }  // namespace pine
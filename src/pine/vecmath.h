@@ -1288,4 +1288,33 @@ inline T min_value(Vector3<T> v) {
   return psl::min(v[0], v[1], v[2]);
 }
 
+// `gamma_encode_u8` looks up floats in [2^-18, 1) by their exponent and top 7 mantissa bits.
+// Every entry holds the output at the start of its range in the high byte and, in the low 17
+// bits, the low mantissa bits from which the output is one higher (0x10000 when it never is);
+// the curve is flat enough that no range spans more than one step
+struct GammaEncodeLut {
+  static constexpr uint32_t first = (127 - 18) << 23;
+  static constexpr int size = 18 << 7;
+
+  GammaEncodeLut();
+  uint32_t entries[size];
+};
+extern const GammaEncodeLut gamma_encode_lut;
+
+// Same result as `uint8_t(min(pow(x, 1 / 2.2f) * 256, 255.0f))`, the 8-bit encoding of
+// `Array2d::from`, without the `pow`. Negative inputs give 0
+inline uint8_t gamma_encode_u8(float x) {
+  // Clamped into the table's range on the bits, where it compiles to cmovs rather than branches
+  // that mispredict on noisy images; positive NaNs order above 1 and so give 255 as before
+  auto bits = psl::bitcast<int32_t>(x);
+  bits = psl::max(bits, int32_t(GammaEncodeLut::first));
+  bits = psl::min(bits, int32_t(0x3f7fffff));
+  auto entry = gamma_encode_lut.entries[uint32_t(bits - GammaEncodeLut::first) >> 16];
+  return uint8_t((entry >> 24) + (uint32_t(bits & 0xffff) >= (entry & 0x1ffff)));
+}
+template <typename T>
+Vector3<uint8_t> gamma_encode_u8(Vector3<T> v) {
+  return {gamma_encode_u8(v.x), gamma_encode_u8(v.y), gamma_encode_u8(v.z)};
+}
+
 }  // namespace pine
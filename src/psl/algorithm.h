@@ -335,6 +335,23 @@ auto greater_or_equal_to(T value) {
 }
 
 // Return the iterator to the first element not satisfying `pred`
+template <Range R>
+requires RandomAccessIterator<IteratorTypeT<R>>
+auto lower_bound(R&& range, auto&& pred) {
+  auto first = psl::begin(range);
+  auto n = psl::distance(first, psl::end(range));
+  if (n == 0)
+    return first;
+
+  // The answer always lies within [first, first + n]; halving `n` unconditionally lets the
+  // comparison become a conditional move instead of a hard-to-predict branch
+  while (n > 1) {
+    auto half = n / 2;
+    first = pred(first[half]) ? first + half : first;
+    n -= half;
+  }
+  return pred(*first) ? first + 1 : first;
+}
 auto lower_bound(Range auto&& range, auto&& pred) {
   auto first = psl::begin(range);
   auto last = psl::end(range);
@@ -463,8 +480,379 @@ auto partition(Range auto&& range, auto&& pred) {
   return tail;
 }
 
-// `comp` must be a strict ordering, i.e. comp(x, x) = false for all valid x
-void sort(Range auto&& range, auto&& comp) {
+constexpr ptrdiff_t _insertion_sort_threshold = 24;
+constexpr ptrdiff_t _ninther_threshold = 128;
+constexpr size_t _partial_insertion_sort_limit = 8;
+constexpr size_t _partition_block_size = 64;
+
+template <typename It, typename Comp>
+void _sort2(It a, It b, Comp& comp) {
+  if (comp(*b, *a))
+    psl::iter_swap(a, b);
+}
+template <typename It, typename Comp>
+void _sort3(It a, It b, It c, Comp& comp) {
+  _sort2(a, b, comp);
+  _sort2(b, c, comp);
+  _sort2(a, b, comp);
+}
+
+template <typename It, typename Comp>
+void _insertion_sort(It first, It last, Comp& comp) {
+  if (first == last)
+    return;
+  for (auto cur = first + 1; cur != last; ++cur) {
+    auto sift = cur;
+    auto sift_1 = cur - 1;
+    if (comp(*sift, *sift_1)) {
+      auto tmp = psl::move(*sift);
+      do {
+        *sift-- = psl::move(*sift_1);
+      } while (sift != first && comp(tmp, *--sift_1));
+      *sift = psl::move(tmp);
+    }
+  }
+}
+// Requires an element before `first` that is not greater than any element of the range
+template <typename It, typename Comp>
+void _unguarded_insertion_sort(It first, It last, Comp& comp) {
+  if (first == last)
+    return;
+  for (auto cur = first + 1; cur != last; ++cur) {
+    auto sift = cur;
+    auto sift_1 = cur - 1;
+    if (comp(*sift, *sift_1)) {
+      auto tmp = psl::move(*sift);
+      do {
+        *sift-- = psl::move(*sift_1);
+      } while (comp(tmp, *--sift_1));
+      *sift = psl::move(tmp);
+    }
+  }
+}
+// Insertion sort that gives up once it has moved too many elements; returns whether it finished
+template <typename It, typename Comp>
+bool _partial_insertion_sort(It first, It last, Comp& comp) {
+  if (first == last)
+    return true;
+  auto moved = size_t(0);
+  for (auto cur = first + 1; cur != last; ++cur) {
+    auto sift = cur;
+    auto sift_1 = cur - 1;
+    if (comp(*sift, *sift_1)) {
+      auto tmp = psl::move(*sift);
+      do {
+        *sift-- = psl::move(*sift_1);
+      } while (sift != first && comp(tmp, *--sift_1));
+      *sift = psl::move(tmp);
+      moved += cur - sift;
+    }
+    if (moved > _partial_insertion_sort_limit)
+      return false;
+  }
+  return true;
+}
+
+template <typename It, typename Comp>
+void _sift_down(It first, ptrdiff_t i, ptrdiff_t n, Comp& comp) {
+  auto x = psl::move(first[i]);
+  while (true) {
+    auto child = 2 * i + 1;
+    if (child >= n)
+      break;
+    if (child + 1 < n && comp(first[child], first[child + 1]))
+      child++;
+    if (!comp(x, first[child]))
+      break;
+    first[i] = psl::move(first[child]);
+    i = child;
+  }
+  first[i] = psl::move(x);
+}
+template <typename It, typename Comp>
+void _make_heap(It first, It last, Comp& comp) {
+  auto n = last - first;
+  for (auto i = n / 2; i-- > 0;)
+    _sift_down(first, i, n, comp);
+}
+template <typename It, typename Comp>
+void _sort_heap(It first, It last, Comp& comp) {
+  for (auto n = last - first; n > 1; n--) {
+    psl::iter_swap(first, first + (n - 1));
+    _sift_down(first, 0, n - 1, comp);
+  }
+}
+
+// Partition [first, last) around the pivot at `first`; elements equal to the pivot go right.
+// Requires the median-of-3 sentinels put in place by `_pdqsort_loop`.
+// Returns the pivot's final position and whether the range was already partitioned
+template <typename It, typename Comp>
+pair<It, bool> _partition_right(It first_, It last_, Comp& comp) {
+  auto pivot = psl::move(*first_);
+  auto first = first_;
+  auto last = last_;
+
+  while (comp(*++first, pivot))
+    ;
+  if (first - 1 == first_)
+    while (first < last && !comp(*--last, pivot))
+      ;
+  else
+    while (!comp(*--last, pivot))
+      ;
+
+  auto already_partitioned = first >= last;
+  while (first < last) {
+    psl::iter_swap(first, last);
+    while (comp(*++first, pivot))
+      ;
+    while (!comp(*--last, pivot))
+      ;
+  }
+
+  auto pivot_pos = first - 1;
+  *first_ = psl::move(*pivot_pos);
+  *pivot_pos = psl::move(pivot);
+  return {pivot_pos, already_partitioned};
+}
+
+template <typename It>
+void _swap_offsets(It first, It last, const unsigned char* offsets_l,
+                   const unsigned char* offsets_r, size_t n, bool use_swaps) {
+  if (use_swaps) {
+    for (size_t i = 0; i < n; i++)
+      psl::iter_swap(first + offsets_l[i], last - offsets_r[i]);
+  } else if (n > 0) {
+    // A cyclic permutation needs fewer moves than swapping pairs
+    auto l = first + offsets_l[0];
+    auto r = last - offsets_r[0];
+    auto tmp = psl::move(*l);
+    *l = psl::move(*r);
+    for (size_t i = 1; i < n; i++) {
+      l = first + offsets_l[i];
+      *r = psl::move(*l);
+      r = last - offsets_r[i];
+      *l = psl::move(*r);
+    }
+    *r = psl::move(tmp);
+  }
+}
+
+// Same contract as `_partition_right`, but the comparisons of each block of elements are recorded
+// as offsets first and the swaps done afterwards, so there's no branch on a comparison's result
+// (Edelkamp and Weiß, "BlockQuicksort")
+template <typename It, typename Comp>
+pair<It, bool> _partition_right_branchless(It first_, It last_, Comp& comp) {
+  auto pivot = psl::move(*first_);
+  auto first = first_;
+  auto last = last_;
+
+  while (comp(*++first, pivot))
+    ;
+  if (first - 1 == first_)
+    while (first < last && !comp(*--last, pivot))
+      ;
+  else
+    while (!comp(*--last, pivot))
+      ;
+
+  auto already_partitioned = first >= last;
+  if (!already_partitioned) {
+    psl::iter_swap(first, last);
+    ++first;
+
+    alignas(64) unsigned char offsets_l[_partition_block_size];
+    alignas(64) unsigned char offsets_r[_partition_block_size];
+    auto offsets_l_base = first;
+    auto offsets_r_base = last;
+    size_t num_l = 0, num_r = 0, start_l = 0, start_r = 0;
+
+    while (first < last) {
+      // Fill the offset blocks that are empty, splitting what's left if both are
+      size_t num_unknown = last - first;
+      auto left_split = num_l == 0 ? (num_r == 0 ? num_unknown / 2 : num_unknown) : 0;
+      auto right_split = num_r == 0 ? (num_unknown - left_split) : 0;
+      left_split = left_split < _partition_block_size ? left_split : _partition_block_size;
+      right_split = right_split < _partition_block_size ? right_split : _partition_block_size;
+
+      for (size_t i = 0; i < left_split; i++) {
+        offsets_l[num_l] = i;
+        num_l += !comp(*first, pivot);
+        ++first;
+      }
+      for (size_t i = 0; i < right_split;) {
+        offsets_r[num_r] = ++i;
+        num_r += comp(*--last, pivot);
+      }
+
+      auto n = num_l < num_r ? num_l : num_r;
+      _swap_offsets(offsets_l_base, offsets_r_base, offsets_l + start_l, offsets_r + start_r, n,
+                    num_l == num_r);
+      num_l -= n;
+      num_r -= n;
+      start_l += n;
+      start_r += n;
+      if (num_l == 0) {
+        start_l = 0;
+        offsets_l_base = first;
+      }
+      if (num_r == 0) {
+        start_r = 0;
+        offsets_r_base = last;
+      }
+    }
+
+    // At most one of the blocks still has misplaced elements; move them to the boundary
+    if (num_l) {
+      while (num_l--)
+        psl::iter_swap(offsets_l_base + offsets_l[start_l + num_l], --last);
+      first = last;
+    }
+    if (num_r) {
+      while (num_r--)
+        psl::iter_swap(offsets_r_base - offsets_r[start_r + num_r], first), ++first;
+      last = first;
+    }
+  }
+
+  auto pivot_pos = first - 1;
+  *first_ = psl::move(*pivot_pos);
+  *pivot_pos = psl::move(pivot);
+  return {pivot_pos, already_partitioned};
+}
+
+// Put the elements equal to the pivot at `first` to its left, used when the pivot equals the
+// element right before the range, so that all of them are already in place
+template <typename It, typename Comp>
+It _partition_left(It first_, It last_, Comp& comp) {
+  auto pivot = psl::move(*first_);
+  auto first = first_;
+  auto last = last_;
+
+  while (comp(pivot, *--last))
+    ;
+  if (last + 1 == last_)
+    while (first < last && !comp(pivot, *++first))
+      ;
+  else
+    while (!comp(pivot, *++first))
+      ;
+
+  while (first < last) {
+    psl::iter_swap(first, last);
+    while (comp(pivot, *--last))
+      ;
+    while (!comp(pivot, *++first))
+      ;
+  }
+
+  auto pivot_pos = last;
+  *first_ = psl::move(*pivot_pos);
+  *pivot_pos = psl::move(pivot);
+  return pivot_pos;
+}
+
+// Pick a median-of-3 pivot, or a pseudo-median of 9 for large ranges, and move it to `first`
+template <typename It, typename Comp>
+void _choose_pivot(It first, It last, Comp& comp) {
+  auto size = last - first;
+  auto s2 = size / 2;
+  if (size > _ninther_threshold) {
+    _sort3(first, first + s2, last - 1, comp);
+    _sort3(first + 1, first + (s2 - 1), last - 2, comp);
+    _sort3(first + 2, first + (s2 + 1), last - 3, comp);
+    _sort3(first + (s2 - 1), first + s2, first + (s2 + 1), comp);
+    psl::iter_swap(first, first + s2);
+  } else {
+    _sort3(first + s2, first, last - 1, comp);
+  }
+}
+
+// Shuffle a few elements around after a highly unbalanced partition to break up patterns
+template <typename It>
+void _break_patterns(It first, It pivot_pos, It last) {
+  auto l_size = pivot_pos - first;
+  auto r_size = last - (pivot_pos + 1);
+  if (l_size >= _insertion_sort_threshold) {
+    psl::iter_swap(first, first + l_size / 4);
+    psl::iter_swap(pivot_pos - 1, pivot_pos - l_size / 4);
+    if (l_size > _ninther_threshold) {
+      psl::iter_swap(first + 1, first + (l_size / 4 + 1));
+      psl::iter_swap(first + 2, first + (l_size / 4 + 2));
+      psl::iter_swap(pivot_pos - 2, pivot_pos - (l_size / 4 + 1));
+      psl::iter_swap(pivot_pos - 3, pivot_pos - (l_size / 4 + 2));
+    }
+  }
+  if (r_size >= _insertion_sort_threshold) {
+    psl::iter_swap(pivot_pos + 1, pivot_pos + (1 + r_size / 4));
+    psl::iter_swap(last - 1, last - r_size / 4);
+    if (r_size > _ninther_threshold) {
+      psl::iter_swap(pivot_pos + 2, pivot_pos + (2 + r_size / 4));
+      psl::iter_swap(pivot_pos + 3, pivot_pos + (3 + r_size / 4));
+      psl::iter_swap(last - 2, last - (1 + r_size / 4));
+      psl::iter_swap(last - 3, last - (2 + r_size / 4));
+    }
+  }
+}
+
+// Pattern-defeating quicksort (Peters, "Pattern-defeating Quicksort").
+// `leftmost` is false when the element before `first` is a valid sentinel; `bad_allowed` is the
+// number of unbalanced partitions tolerated before switching to heapsort
+template <bool branchless, typename It, typename Comp>
+void _pdqsort_loop(It first, It last, Comp& comp, int bad_allowed, bool leftmost) {
+  while (true) {
+    auto size = last - first;
+    if (size < _insertion_sort_threshold) {
+      if (leftmost)
+        _insertion_sort(first, last, comp);
+      else
+        _unguarded_insertion_sort(first, last, comp);
+      return;
+    }
+
+    _choose_pivot(first, last, comp);
+
+    // Equal to the sentinel on the left means every element equal to the pivot is in place
+    if (!leftmost && !comp(*(first - 1), *first)) {
+      first = _partition_left(first, last, comp) + 1;
+      continue;
+    }
+
+    auto [pivot_pos, already_partitioned] = branchless
+                                                ? _partition_right_branchless(first, last, comp)
+                                                : _partition_right(first, last, comp);
+
+    auto l_size = pivot_pos - first;
+    auto r_size = last - (pivot_pos + 1);
+    if (l_size < size / 8 || r_size < size / 8) {
+      if (--bad_allowed == 0) {
+        _make_heap(first, last, comp);
+        _sort_heap(first, last, comp);
+        return;
+      }
+      _break_patterns(first, pivot_pos, last);
+    } else if (already_partitioned && _partial_insertion_sort(first, pivot_pos, comp) &&
+               _partial_insertion_sort(pivot_pos + 1, last, comp)) {
+      // Likely a (nearly) sorted range
+      return;
+    }
+
+    _pdqsort_loop<branchless>(first, pivot_pos, comp, bad_allowed, leftmost);
+    first = pivot_pos + 1;
+    leftmost = false;
+  }
+}
+
+inline int _log2_floor(size_t n) {
+  return n ? 63 - __builtin_clzll(n) : 0;
+}
+
+// Elements that are cheap to move are partitioned without branching on comparisons
+template <typename It>
+constexpr bool _sort_branchless = __is_trivially_copyable(IteratorValueType<It>);
+
+// The naive quicksort for ranges without random access
+void _quicksort(Range auto&& range, auto&& comp) {
   auto first = psl::begin(range);
   auto last = psl::end(range);
   if (first == last)
@@ -472,20 +860,171 @@ void sort(Range auto&& range, auto&& comp) {
   if (psl::next(first) == last)
     return;
 
-  auto pivot = psl::partition(range, [rhs = *first, &comp](auto&& lhs) { return comp(lhs, rhs); });
+  // Partition everything after the pivot, then swap the pivot into its final position
+  auto pivot = psl::partition(psl::range(psl::next(first), last),
+                              [&rhs = *first, &comp](auto&& lhs) { return comp(lhs, rhs); });
+  --pivot;
+  psl::iter_swap(first, pivot);
 
-  psl::sort(psl::range(first, pivot), comp);
+  psl::_quicksort(psl::range(first, pivot), comp);
   ++pivot;
-  psl::sort(psl::range(pivot, last), comp);
+  psl::_quicksort(psl::range(pivot, last), comp);
+}
+
+// `comp` must be a strict ordering, i.e. comp(x, x) = false for all valid x.
+// Random-access ranges are sorted with pdqsort in O(n log n) worst case and O(n) on sorted or
+// reversed input; the order of equal elements is unspecified
+template <Range R, typename Comp>
+void sort(R&& range, Comp&& comp) {
+  using It = IteratorTypeT<R>;
+  if constexpr (RandomAccessIterator<It>) {
+    auto first = psl::begin(range);
+    auto last = psl::end(range);
+    if (last - first < 2)
+      return;
+    _pdqsort_loop<_sort_branchless<It>>(first, last, comp, _log2_floor(last - first), true);
+  } else {
+    psl::_quicksort(range, comp);
+  }
 }
+void sort(Range auto&& range) {
+  psl::sort(range, less<>());
+}
+
+// Merge the sorted runs [first, middle) and [middle, last) through `buffer`, which has room for
+// the first run
+template <typename It, typename T, typename Comp>
+void _merge_with_buffer(It first, It middle, It last, T* buffer, Comp& comp) {
+  // Already in order, which is common for nearly sorted input
+  if (!comp(*middle, *(middle - 1)))
+    return;
+
+  auto n = middle - first;
+  for (ptrdiff_t i = 0; i < n; i++)
+    psl::construct_at(buffer + i, psl::move(first[i]));
+
+  auto b = buffer, b_end = buffer + n;
+  auto out = first;
+  auto r = middle;
+  // Taking from the buffer on ties keeps equal elements in their original order
+  while (b != b_end && r != last) {
+    if (comp(*r, *b))
+      *out++ = psl::move(*r++);
+    else
+      *out++ = psl::move(*b++);
+  }
+  while (b != b_end)
+    *out++ = psl::move(*b++);
 
-// void nth_element(Range auto&& range, ForwardIterator auto it, auto&& f) {
-//   (void)it;
-//   sort(range, f);
-// }
-// void partial_sort(Range auto&& range, ForwardIterator auto it [[maybe_unused]], auto&& f) {
-//   sort(range, f);
-// }
+  for (ptrdiff_t i = 0; i < n; i++)
+    psl::destruct_at(buffer + i);
+}
+template <typename It, typename T, typename Comp>
+void _merge_sort(It first, It last, T* buffer, Comp& comp) {
+  if (last - first <= _insertion_sort_threshold) {
+    _insertion_sort(first, last, comp);
+    return;
+  }
+  auto middle = first + (last - first) / 2;
+  _merge_sort(first, middle, buffer, comp);
+  _merge_sort(middle, last, buffer, comp);
+  _merge_with_buffer(first, middle, last, buffer, comp);
+}
+
+// Sort while keeping equal elements in their original order.
+// A merge sort with a scratch buffer of half the range's size
+template <Range R, typename Comp>
+void stable_sort(R&& range, Comp&& comp) {
+  using T = IteratorValueType<IteratorTypeT<R>>;
+  auto first = psl::begin(range);
+  auto last = psl::end(range);
+  auto n = last - first;
+  if (n < 2)
+    return;
+  auto buffer = (T*)::operator new(sizeof(T) * (n / 2 + 1), std::align_val_t(alignof(T)));
+  _merge_sort(first, last, buffer, comp);
+  ::operator delete(buffer, std::align_val_t(alignof(T)));
+}
+void stable_sort(Range auto&& range) {
+  psl::stable_sort(range, less<>());
+}
+
+// Rearrange the range so that `nth` holds the element it would hold if the range were sorted,
+// with no element before it greater and no element after it less.
+// Quickselect with pdqsort's partitioning; falls back to sorting the rest on bad pivots
+template <Range R, typename Comp>
+void nth_element(R&& range, IteratorTypeT<R> nth, Comp&& comp) {
+  using It = IteratorTypeT<R>;
+  auto first = psl::begin(range);
+  auto last = psl::end(range);
+  if (nth == last)
+    return;
+  auto bad_allowed = _log2_floor(last - first);
+  auto leftmost = true;
+
+  while (last - first >= _insertion_sort_threshold) {
+    _choose_pivot(first, last, comp);
+    if (!leftmost && !comp(*(first - 1), *first)) {
+      auto pivot_pos = _partition_left(first, last, comp);
+      if (nth <= pivot_pos)
+        return;
+      first = pivot_pos + 1;
+      continue;
+    }
+
+    auto pivot_pos = _sort_branchless<It> ? _partition_right_branchless(first, last, comp).first
+                                          : _partition_right(first, last, comp).first;
+    if (pivot_pos == nth)
+      return;
+
+    auto size = last - first;
+    auto l_size = pivot_pos - first;
+    auto r_size = last - (pivot_pos + 1);
+    if (l_size < size / 8 || r_size < size / 8) {
+      if (--bad_allowed == 0) {
+        _make_heap(first, last, comp);
+        _sort_heap(first, last, comp);
+        return;
+      }
+      _break_patterns(first, pivot_pos, last);
+    }
+
+    if (nth < pivot_pos) {
+      last = pivot_pos;
+    } else {
+      first = pivot_pos + 1;
+      leftmost = false;
+    }
+  }
+  _insertion_sort(first, last, comp);
+}
+template <Range R>
+void nth_element(R&& range, IteratorTypeT<R> nth) {
+  psl::nth_element(range, nth, less<>());
+}
+
+// Sort the smallest `middle - begin` elements into [begin, middle); the order of the rest is
+// unspecified. Heap selection followed by heapsort, O(n log k)
+template <Range R, typename Comp>
+void partial_sort(R&& range, IteratorTypeT<R> middle, Comp&& comp) {
+  auto first = psl::begin(range);
+  auto last = psl::end(range);
+  if (first == middle)
+    return;
+  _make_heap(first, middle, comp);
+  auto k = middle - first;
+  for (auto it = middle; it != last; ++it) {
+    if (comp(*it, *first)) {
+      psl::swap(*it, *first);
+      _sift_down(first, 0, k, comp);
+    }
+  }
+  _sort_heap(first, middle, comp);
+}
+template <Range R>
+void partial_sort(R&& range, IteratorTypeT<R> middle) {
+  psl::partial_sort(range, middle, less<>());
+}
 
 void reverse(Range auto&& range) {
   auto first = psl::begin(range);
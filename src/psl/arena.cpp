@@ -0,0 +1,64 @@
+#include <psl/arena.h>
+
+namespace psl {
+
+monotonic_arena::monotonic_arena(size_t block_size) : block_size(block_size) {
+}
+monotonic_arena::~monotonic_arena() {
+  release();
+}
+
+void monotonic_arena::grow(size_t min_size) {
+  auto size = psl::max(block_size, min_size);
+  auto block = (Block*)::operator new(sizeof(Block) + size);
+  block->next = blocks;
+  block->size = size;
+  blocks = block;
+  cursor = data(block);
+  end = cursor + size;
+  reserved += size;
+}
+
+void* monotonic_arena::alloc_dedicated(size_t size, size_t alignment) {
+  auto block = (Block*)::operator new(sizeof(Block) + size + alignment);
+  block->size = size + alignment;
+  if (blocks) {
+    block->next = blocks->next;
+    blocks->next = block;
+  } else {
+    block->next = nullptr;
+    blocks = block;
+  }
+  reserved += block->size;
+  auto p = align_up(data(block), alignment);
+  used += (p + size) - data(block);
+  high_water_mark = psl::max(high_water_mark, used);
+  return p;
+}
+
+void monotonic_arena::release() {
+  while (blocks) {
+    auto next = blocks->next;
+    ::operator delete(blocks);
+    blocks = next;
+  }
+  cursor = end = nullptr;
+  used = 0;
+  reserved = 0;
+}
+
+void frame_arena::reset() {
+  if (blocks && blocks->next) {
+    auto total = reserved;
+    release();
+    grow(total);
+  }
+  if (blocks) {
+    cursor = data(blocks);
+    end = cursor + blocks->size;
+  }
+  used = 0;
+  frame++;
+}
+
+}  // namespace psl
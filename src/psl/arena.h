@@ -0,0 +1,117 @@
+#pragma once
+
+#include <psl/memory.h>
+#include <psl/math.h>
+
+namespace psl {
+
+struct arena_stats {
+  // Bytes handed out since the last reset, including alignment padding
+  size_t bytes_used = 0;
+  // The largest `bytes_used` ever reached
+  size_t high_water_mark = 0;
+  // Bytes currently held in blocks
+  size_t bytes_reserved = 0;
+};
+
+// Hands out memory by bumping a pointer through large blocks.
+// `free` does nothing; the memory is returned when the arena is released or destroyed
+class monotonic_arena {
+public:
+  static constexpr size_t default_alignment = 16;
+
+  explicit monotonic_arena(size_t block_size = size_t(64) << 10);
+  ~monotonic_arena();
+
+  monotonic_arena(const monotonic_arena&) = delete;
+  monotonic_arena& operator=(const monotonic_arena&) = delete;
+
+  void* alloc(size_t size, size_t alignment = default_alignment) {
+    auto p = align_up(cursor, alignment);
+    if (p + size > end) {
+      if (size + alignment > block_size / 2)
+        return alloc_dedicated(size, alignment);
+      grow(size + alignment);
+      p = align_up(cursor, alignment);
+    }
+    used += (p + size) - cursor;
+    cursor = p + size;
+    high_water_mark = psl::max(high_water_mark, used);
+    return p;
+  }
+  void free(void*) {
+  }
+
+  // Return every block to the heap
+  void release();
+
+  arena_stats stats() const {
+    return {used, high_water_mark, reserved};
+  }
+
+protected:
+  struct Block {
+    Block* next;
+    size_t size;
+  };
+
+  static char* align_up(char* p, size_t alignment) {
+    return (char*)((uintptr_t(p) + alignment - 1) & ~uintptr_t(alignment - 1));
+  }
+  static char* data(Block* block) {
+    return (char*)(block + 1);
+  }
+
+  void grow(size_t min_size);
+  // A block of its own for a size that would waste much of a fresh one, linked in behind the
+  // current block so that `cursor` and `end` keep serving the smaller allocations
+  void* alloc_dedicated(size_t size, size_t alignment);
+
+  Block* blocks = nullptr;
+  char* cursor = nullptr;
+  char* end = nullptr;
+  size_t block_size;
+  size_t used = 0;
+  size_t high_water_mark = 0;
+  size_t reserved = 0;
+};
+
+// A monotonic arena that is rewound once per frame.
+// If a frame spilled into several blocks, `reset` merges them into one so the next frames
+// are served from a single block without touching the heap
+class frame_arena : public monotonic_arena {
+public:
+  using monotonic_arena::monotonic_arena;
+
+  void reset();
+
+  size_t frame_index() const {
+    return frame;
+  }
+
+private:
+  size_t frame = 0;
+};
+
+// Lets an arena be pushed with `push_context_allocator`; the arena must outlive the push
+template <typename Arena>
+struct arena_resource {
+  static constexpr bool noop_free = true;
+
+  void* alloc(size_t size) {
+    return arena->alloc(size);
+  }
+  void free(void*) {
+  }
+
+  Arena* arena;
+};
+
+inline void push_context_allocator(monotonic_arena& arena) {
+  psl::push_context_allocator(pm_allocator(arena_resource<monotonic_arena>{&arena}));
+}
+inline void push_context_allocator(frame_arena& arena) {
+  psl::push_context_allocator(pm_allocator(arena_resource<frame_arena>{&arena}));
+}
+
+}  // namespace psl
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <psl/type_traits.h>
+#include <psl/stdint.h>
+
+namespace psl {
+
+// Data written by different threads is kept this far apart, so that they don't contend for a line
+constexpr size_t cache_line_size = 64;
+
+enum class memory_order : int {
+  relaxed = __ATOMIC_RELAXED,
+  consume = __ATOMIC_CONSUME,
+  acquire = __ATOMIC_ACQUIRE,
+  release = __ATOMIC_RELEASE,
+  acq_rel = __ATOMIC_ACQ_REL,
+  seq_cst = __ATOMIC_SEQ_CST
+};
+
+// Free functions over plain objects, for memory that is only sometimes shared between threads
+template <typename T>
+T atomic_load(const T* ptr, memory_order order = memory_order::seq_cst) {
+  return __atomic_load_n(ptr, int(order));
+}
+template <typename T>
+void atomic_store(T* ptr, T value, memory_order order = memory_order::seq_cst) {
+  __atomic_store_n(ptr, value, int(order));
+}
+template <typename T>
+T atomic_fetch_add(T* ptr, T value, memory_order order = memory_order::seq_cst) {
+  return __atomic_fetch_add(ptr, value, int(order));
+}
+template <typename T>
+T atomic_fetch_sub(T* ptr, T value, memory_order order = memory_order::seq_cst) {
+  return __atomic_fetch_sub(ptr, value, int(order));
+}
+inline void atomic_thread_fence(memory_order order) {
+  __atomic_thread_fence(int(order));
+}
+// Block until `*ptr` is no longer `old`; returns right away if it isn't already.
+// Wakeups may be spurious, so callers re-check their condition
+void atomic_wait(const int* ptr, int old);
+// Wake every thread blocked in `atomic_wait` on `ptr`
+void atomic_notify_all(int* ptr);
+
+template <typename T>
+struct atomic {
+  static_assert(__is_trivially_copyable(T), "atomic<T> requires a trivially copyable T");
+
+  atomic() = default;
+  constexpr atomic(T value) : value(value) {
+  }
+  atomic(const atomic&) = delete;
+  atomic& operator=(const atomic&) = delete;
+
+  T load(memory_order order = memory_order::seq_cst) const {
+    return __atomic_load_n(&value, int(order));
+  }
+  void store(T x, memory_order order = memory_order::seq_cst) {
+    __atomic_store_n(&value, x, int(order));
+  }
+  T exchange(T x, memory_order order = memory_order::seq_cst) {
+    return __atomic_exchange_n(&value, x, int(order));
+  }
+  bool compare_exchange_weak(T& expected, T desired, memory_order success = memory_order::seq_cst,
+                             memory_order failure = memory_order::seq_cst) {
+    return __atomic_compare_exchange_n(&value, &expected, desired, true, int(success),
+                                       int(failure));
+  }
+  bool compare_exchange_strong(T& expected, T desired,
+                               memory_order success = memory_order::seq_cst,
+                               memory_order failure = memory_order::seq_cst) {
+    return __atomic_compare_exchange_n(&value, &expected, desired, false, int(success),
+                                       int(failure));
+  }
+  T fetch_add(T x, memory_order order = memory_order::seq_cst) {
+    return __atomic_fetch_add(&value, x, int(order));
+  }
+  T fetch_sub(T x, memory_order order = memory_order::seq_cst) {
+    return __atomic_fetch_sub(&value, x, int(order));
+  }
+
+  void wait(T old) const
+  requires SameAs<T, int>
+  {
+    psl::atomic_wait(&value, old);
+  }
+  void notify_all()
+  requires SameAs<T, int>
+  {
+    psl::atomic_notify_all(&value);
+  }
+
+  operator T() const {
+    return load();
+  }
+  atomic& operator=(T x) {
+    store(x);
+    return *this;
+  }
+
+private:
+  T value;
+};
+
+}  // namespace psl
@@ -0,0 +1,271 @@
+#pragma once
+
+#include <psl/memory.h>
+#include <psl/math.h>
+#include <psl/check.h>
+#include <psl/new.h>
+
+namespace psl {
+
+// An unordered container whose elements never move: they live in fixed-size blocks that are
+// allocated as the container grows and freed once they empty out.
+// Each block has an occupancy bitmask that serves as its skip field, so iteration jumps over
+// erased slots a word at a time, and blocks with free slots are kept on a free list, so insertion
+// and erasure are O(1). Pointers and iterators stay valid until their own element is erased.
+// Blocks are aligned to their size, which lets `erase` find an element's block from its address
+template <typename T, size_t block_size = 64>
+class colony {
+  static_assert(block_size % 64 == 0, "colony's block size must be a multiple of 64");
+  static constexpr size_t n_words = block_size / 64;
+
+  struct Block {
+    Storage<sizeof(T) * block_size, alignof(T)> slots;
+    uint64_t occupied[n_words] = {};
+    Block* prev = nullptr;
+    Block* next = nullptr;
+    Block* prev_free = nullptr;
+    Block* next_free = nullptr;
+    size_t count = 0;
+
+    T* slot(size_t i) {
+      return slots.template ptr<T>() + i;
+    }
+    bool has(size_t i) const {
+      return occupied[i / 64] & (uint64_t(1) << (i % 64));
+    }
+    // The first occupied slot at or after `i`, or `block_size` if there's none
+    size_t next_occupied(size_t i) const {
+      for (auto w = i / 64; w < n_words; w++) {
+        auto bits = occupied[w];
+        if (w == i / 64)
+          bits &= ~uint64_t(0) << (i % 64);
+        if (bits)
+          return w * 64 + __builtin_ctzll(bits);
+      }
+      return block_size;
+    }
+    size_t first_free() const {
+      for (size_t w = 0;; w++)
+        if (~occupied[w])
+          return w * 64 + __builtin_ctzll(~occupied[w]);
+    }
+  };
+  static constexpr size_t block_alignment = psl::roundup2(sizeof(Block));
+
+public:
+  using ValueType = T;
+
+  template <bool is_const>
+  struct IteratorImpl {
+    using ValueType = Conditional<is_const, const T, T>;
+    using ReferenceType = ValueType&;
+    using DifferenceType = ptrdiff_t;
+
+    IteratorImpl() = default;
+    IteratorImpl(Block* block, size_t index) : block(block), index(index) {
+      skip_empty();
+    }
+    operator IteratorImpl<true>() const {
+      return {block, index};
+    }
+
+    ValueType& operator*() const {
+      return *block->slot(index);
+    }
+    ValueType* operator->() const {
+      return block->slot(index);
+    }
+    IteratorImpl& operator++() {
+      index = block->next_occupied(index + 1);
+      skip_empty();
+      return *this;
+    }
+    IteratorImpl operator++(int) {
+      auto copy = *this;
+      ++(*this);
+      return copy;
+    }
+    friend bool operator==(const IteratorImpl& lhs, const IteratorImpl& rhs) {
+      return lhs.block == rhs.block && lhs.index == rhs.index;
+    }
+    friend bool operator!=(const IteratorImpl& lhs, const IteratorImpl& rhs) {
+      return !(lhs == rhs);
+    }
+
+  private:
+    friend class colony;
+
+    // Move on to the next block while there's nothing left in this one; there's at most one
+    // empty block, kept around for the next insertion
+    void skip_empty() {
+      while (block && index == block_size) {
+        block = block->next;
+        index = block ? block->next_occupied(0) : 0;
+      }
+    }
+
+    Block* block = nullptr;
+    size_t index = 0;
+  };
+  using Iterator = IteratorImpl<false>;
+  using ConstIterator = IteratorImpl<true>;
+
+  colony() = default;
+  ~colony() {
+    clear();
+  }
+  colony(const colony& rhs) {
+    for (const auto& x : rhs)
+      insert(x);
+  }
+  colony(colony&& rhs) {
+    swap(rhs);
+  }
+  colony& operator=(colony rhs) {
+    swap(rhs);
+    return *this;
+  }
+  void swap(colony& rhs) {
+    psl::swap(head, rhs.head);
+    psl::swap(tail, rhs.tail);
+    psl::swap(free_head, rhs.free_head);
+    psl::swap(len, rhs.len);
+  }
+
+  template <typename... Args>
+  T& emplace(Args&&... args) {
+    if (!free_head)
+      push_block();
+    auto block = free_head;
+    auto i = block->first_free();
+    psl::construct_at(block->slot(i), psl::forward<Args>(args)...);
+    block->occupied[i / 64] |= uint64_t(1) << (i % 64);
+    if (++block->count == block_size)
+      unlink_free(block);
+    len++;
+    return *block->slot(i);
+  }
+  T& insert(T x) {
+    return emplace(psl::move(x));
+  }
+
+  // Erase the element `ptr` points to, which must be in this colony
+  void erase(const T* ptr) {
+    auto block = block_of(ptr);
+    auto i = size_t(ptr - block->slot(0));
+    psl_check(block->has(i));
+    psl::destruct_at(block->slot(i));
+    block->occupied[i / 64] &= ~(uint64_t(1) << (i % 64));
+    if (block->count-- == block_size)
+      link_free(block);
+    len--;
+    // Keep one empty block when there's no other room, so that erasing and inserting around a
+    // block boundary doesn't allocate each time
+    if (block->count == 0 && (free_head != block || block->next_free))
+      pop_block(block);
+  }
+  // Returns the iterator to the element after `it`
+  Iterator erase(ConstIterator it) {
+    auto next = Iterator(it.block, it.index);
+    ++next;
+    erase(&*it);
+    return next;
+  }
+  // Erase every element satisfying `pred`; returns the number of elements erased
+  size_t erase_if(auto&& pred) {
+    auto n = size_t(0);
+    for (auto it = begin(); it != end();) {
+      if (pred(*it)) {
+        it = erase(it);
+        n++;
+      } else {
+        ++it;
+      }
+    }
+    return n;
+  }
+
+  void clear() {
+    for (auto block = head; block;) {
+      for (auto i = block->next_occupied(0); i != block_size; i = block->next_occupied(i + 1))
+        psl::destruct_at(block->slot(i));
+      auto next = block->next;
+      free_block(block);
+      block = next;
+    }
+    head = tail = free_head = nullptr;
+    len = 0;
+  }
+
+  // The iterator to the element `ptr` points to, which must be in this colony
+  Iterator iterator_to(T* ptr) {
+    auto block = block_of(ptr);
+    return Iterator(block, size_t(ptr - block->slot(0)));
+  }
+
+  Iterator begin() {
+    return head ? Iterator(head, head->next_occupied(0)) : end();
+  }
+  Iterator end() {
+    return Iterator();
+  }
+  ConstIterator begin() const {
+    return head ? ConstIterator(head, head->next_occupied(0)) : end();
+  }
+  ConstIterator end() const {
+    return ConstIterator();
+  }
+
+  size_t size() const {
+    return len;
+  }
+  bool empty() const {
+    return len == 0;
+  }
+
+private:
+  static Block* block_of(const T* ptr) {
+    return (Block*)(uintptr_t(ptr) & ~uintptr_t(block_alignment - 1));
+  }
+  static void free_block(Block* block) {
+    block->~Block();
+    ::operator delete(block, std::align_val_t(block_alignment));
+  }
+
+  void push_block() {
+    auto block = ::new (::operator new(sizeof(Block), std::align_val_t(block_alignment))) Block;
+    block->prev = tail;
+    if (tail)
+      tail->next = block;
+    else
+      head = block;
+    tail = block;
+    link_free(block);
+  }
+  void pop_block(Block* block) {
+    unlink_free(block);
+    (block->prev ? block->prev->next : head) = block->next;
+    (block->next ? block->next->prev : tail) = block->prev;
+    free_block(block);
+  }
+  void link_free(Block* block) {
+    block->prev_free = nullptr;
+    block->next_free = free_head;
+    if (free_head)
+      free_head->prev_free = block;
+    free_head = block;
+  }
+  void unlink_free(Block* block) {
+    (block->prev_free ? block->prev_free->next_free : free_head) = block->next_free;
+    if (block->next_free)
+      block->next_free->prev_free = block->prev_free;
+    block->prev_free = block->next_free = nullptr;
+  }
+
+  Block* head = nullptr;
+  Block* tail = nullptr;
+  Block* free_head = nullptr;
+  size_t len = 0;
+};
+
+}  // namespace psl
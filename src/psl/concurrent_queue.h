@@ -0,0 +1,184 @@
+#pragma once
+
+#include <psl/atomic.h>
+#include <psl/memory.h>
+#include <psl/optional.h>
+#include <psl/math.h>
+#include <psl/check.h>
+#include <psl/new.h>
+
+namespace psl {
+
+// A bounded lock-free queue for exactly one producer thread and one consumer thread.
+// Each side owns its index and keeps a cached copy of the other side's, which it only reloads
+// when the queue looks full or empty, so in steady state neither touches the other's cache line
+template <typename T>
+class spsc_queue {
+public:
+  // `capacity` is rounded up to a power of two
+  explicit spsc_queue(size_t capacity)
+      : mask(psl::roundup2(psl::max(capacity, size_t(2))) - 1),
+        slots((T*)::operator new(sizeof(T) * (mask + 1), std::align_val_t(cache_line_size))) {
+  }
+  ~spsc_queue() {
+    while (try_pop())
+      ;
+    ::operator delete(slots, std::align_val_t(cache_line_size));
+  }
+  spsc_queue(const spsc_queue&) = delete;
+  spsc_queue& operator=(const spsc_queue&) = delete;
+
+  // Producer side; returns false without taking `args` if the queue is full
+  template <typename... Args>
+  bool try_emplace(Args&&... args) {
+    auto tail = producer.index.load(memory_order::relaxed);
+    if (tail - producer.cached_other > mask) {
+      producer.cached_other = consumer.index.load(memory_order::acquire);
+      if (tail - producer.cached_other > mask)
+        return false;
+    }
+    psl::construct_at(slots + (tail & mask), psl::forward<Args>(args)...);
+    producer.index.store(tail + 1, memory_order::release);
+    return true;
+  }
+  bool try_push(const T& x) {
+    return try_emplace(x);
+  }
+  bool try_push(T&& x) {
+    return try_emplace(psl::move(x));
+  }
+
+  // Consumer side
+  optional<T> try_pop() {
+    auto head = consumer.index.load(memory_order::relaxed);
+    if (head == consumer.cached_other) {
+      consumer.cached_other = producer.index.load(memory_order::acquire);
+      if (head == consumer.cached_other)
+        return nullopt;
+    }
+    auto slot = slots + (head & mask);
+    auto x = optional<T>(psl::move(*slot));
+    psl::destruct_at(slot);
+    consumer.index.store(head + 1, memory_order::release);
+    return x;
+  }
+
+  // Only exact when neither side is running
+  size_t size() const {
+    return producer.index.load(memory_order::acquire) - consumer.index.load(memory_order::acquire);
+  }
+  size_t capacity() const {
+    return mask + 1;
+  }
+
+private:
+  struct alignas(cache_line_size) Side {
+    atomic<size_t> index = 0;
+    size_t cached_other = 0;
+  };
+
+  Side producer;
+  Side consumer;
+  size_t mask;
+  T* slots;
+};
+
+// A bounded lock-free queue for any number of producers and consumers (Vyukov's MPMC queue).
+// Every cell carries a sequence number that says whether it's ready to be written or read for a
+// given position, so a push or pop is one compare-and-swap on the position plus one release store
+template <typename T>
+class mpmc_queue {
+public:
+  // `capacity` is rounded up to a power of two
+  explicit mpmc_queue(size_t capacity)
+      : mask(psl::roundup2(psl::max(capacity, size_t(2))) - 1),
+        cells((Cell*)::operator new(sizeof(Cell) * (mask + 1), std::align_val_t(cache_line_size))) {
+    for (size_t i = 0; i <= mask; i++)
+      psl::construct_at(&cells[i].sequence, i);
+  }
+  ~mpmc_queue() {
+    while (try_pop())
+      ;
+    ::operator delete(cells, std::align_val_t(cache_line_size));
+  }
+  mpmc_queue(const mpmc_queue&) = delete;
+  mpmc_queue& operator=(const mpmc_queue&) = delete;
+
+  // Returns false without taking `args` if the queue is full
+  template <typename... Args>
+  bool try_emplace(Args&&... args) {
+    auto pos = enqueue_pos.value.load(memory_order::relaxed);
+    Cell* cell;
+    while (true) {
+      cell = &cells[pos & mask];
+      auto seq = cell->sequence.load(memory_order::acquire);
+      auto diff = ptrdiff_t(seq - pos);
+      if (diff == 0) {
+        if (enqueue_pos.value.compare_exchange_weak(pos, pos + 1, memory_order::relaxed,
+                                                    memory_order::relaxed))
+          break;
+      } else if (diff < 0) {
+        // The cell still holds the value pushed one lap ago
+        return false;
+      } else {
+        pos = enqueue_pos.value.load(memory_order::relaxed);
+      }
+    }
+    psl::construct_at(cell->slot(), psl::forward<Args>(args)...);
+    cell->sequence.store(pos + 1, memory_order::release);
+    return true;
+  }
+  bool try_push(const T& x) {
+    return try_emplace(x);
+  }
+  bool try_push(T&& x) {
+    return try_emplace(psl::move(x));
+  }
+
+  optional<T> try_pop() {
+    auto pos = dequeue_pos.value.load(memory_order::relaxed);
+    Cell* cell;
+    while (true) {
+      cell = &cells[pos & mask];
+      auto seq = cell->sequence.load(memory_order::acquire);
+      auto diff = ptrdiff_t(seq - (pos + 1));
+      if (diff == 0) {
+        if (dequeue_pos.value.compare_exchange_weak(pos, pos + 1, memory_order::relaxed,
+                                                    memory_order::relaxed))
+          break;
+      } else if (diff < 0) {
+        return nullopt;
+      } else {
+        pos = dequeue_pos.value.load(memory_order::relaxed);
+      }
+    }
+    auto x = optional<T>(psl::move(*cell->slot()));
+    psl::destruct_at(cell->slot());
+    cell->sequence.store(pos + mask + 1, memory_order::release);
+    return x;
+  }
+
+  size_t capacity() const {
+    return mask + 1;
+  }
+
+private:
+  struct Cell {
+    T* slot() {
+      return storage.template ptr<T>();
+    }
+
+    atomic<size_t> sequence;
+    Storage<sizeof(T), alignof(T)> storage;
+  };
+  struct alignas(cache_line_size) PaddedPosition {
+    atomic<size_t> value = 0;
+  };
+
+  PaddedPosition enqueue_pos;
+  PaddedPosition dequeue_pos;
+  size_t mask;
+  Cell* cells;
+};
+
+}  // namespace psl
@@ -0,0 +1,30 @@
+#include <psl/cpu.h>
+#include <psl/atomic.h>
+
+namespace psl {
+
+#ifdef PSL_X86
+static atomic<CpuLevel> max_cpu_level = CpuLevel::Avx512;
+
+void set_max_cpu_level(CpuLevel level) {
+  max_cpu_level.store(level, memory_order::relaxed);
+}
+
+bool has_avx2_fma() {
+  static const bool supported = [] {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+  }();
+  return supported && max_cpu_level.load(memory_order::relaxed) >= CpuLevel::Avx2;
+}
+bool has_avx512() {
+  static const bool supported = [] {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") &&
+           __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vl");
+  }();
+  return supported && max_cpu_level.load(memory_order::relaxed) >= CpuLevel::Avx512;
+}
+#endif
+
+}  // namespace psl
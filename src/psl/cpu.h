@@ -0,0 +1,27 @@
+#pragma once
+
+// Kernels for instruction sets beyond the build's baseline are compiled with these attributes,
+// whatever the build flags, and only called once the CPU is known to support them
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PSL_X86
+#define PSL_AVX2 __attribute__((target("avx2,fma")))
+#define PSL_AVX512 __attribute__((target("avx512f,avx512vl,avx2,fma")))
+#endif
+
+namespace psl {
+
+#ifdef PSL_X86
+// Whether the CPU running the program supports `PSL_AVX2` and `PSL_AVX512` functions.
+// Checked on first call, which may happen during static initialization
+bool has_avx2_fma();
+bool has_avx512();
+
+// The widest instruction set `has_avx2_fma` and `has_avx512` report from now on, whatever the CPU
+// supports, so tests can reach the narrower kernels on any machine. Kernels that were already
+// resolved, like those of `psl::memcpy`, keep theirs
+enum class CpuLevel { Baseline, Avx2, Avx512 };
+void set_max_cpu_level(CpuLevel level);
+#endif
+
+}  // namespace psl
@@ -0,0 +1,399 @@
+#pragma once
+
+#include <psl/hash.h>
+#include <psl/utility.h>
+#include <psl/check.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace psl {
+
+// Control bytes: a full slot stores the low 7 bits of its hash, free slots have the sign bit set
+constexpr int8_t _ctrl_empty = -128;
+constexpr int8_t _ctrl_deleted = -2;
+
+// Matches 16 control bytes at once; bit i of a mask stands for the i-th slot of the group
+struct _swiss_group {
+  static constexpr size_t width = 16;
+
+#if defined(__SSE2__)
+  explicit _swiss_group(const int8_t* ctrl) : ctrl(_mm_load_si128((const __m128i*)ctrl)) {
+  }
+
+  uint32_t match(int8_t h2) const {
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(h2)));
+  }
+  uint32_t match_empty() const {
+    return match(_ctrl_empty);
+  }
+  uint32_t match_free() const {
+    return _mm_movemask_epi8(ctrl);
+  }
+
+  __m128i ctrl;
+#else
+  explicit _swiss_group(const int8_t* ctrl) {
+    for (size_t i = 0; i < width; i++)
+      this->ctrl[i] = ctrl[i];
+  }
+
+  uint32_t match(int8_t h2) const {
+    auto mask = 0u;
+    for (size_t i = 0; i < width; i++)
+      mask |= uint32_t(ctrl[i] == h2) << i;
+    return mask;
+  }
+  uint32_t match_empty() const {
+    return match(_ctrl_empty);
+  }
+  uint32_t match_free() const {
+    auto mask = 0u;
+    for (size_t i = 0; i < width; i++)
+      mask |= uint32_t(ctrl[i] < 0) << i;
+    return mask;
+  }
+
+  int8_t ctrl[width];
+#endif
+};
+
+// An open-addressing hash map that stores its entries inline, in the style of Swiss tables.
+// Slots come in aligned groups of 16 whose control bytes are probed together, and the table grows
+// once it's 7/8 full. Entries move when the table grows, so pointers to them aren't stable
+template <typename Key, typename Value, typename Hash = hasher<Key>>
+class flat_hash_map {
+public:
+  using key_type = Key;
+  using value_type = pair<Key, Value>;
+  static constexpr size_t group_width = _swiss_group::width;
+
+  template <bool is_const>
+  struct IteratorImpl {
+    using Entry = Conditional<is_const, const value_type, value_type>;
+
+    IteratorImpl() = default;
+    IteratorImpl(const int8_t* ctrl, Entry* slot, const int8_t* end)
+        : ctrl(ctrl), slot(slot), end(end) {
+      skip_free();
+    }
+    operator IteratorImpl<true>() const {
+      return {ctrl, slot, end};
+    }
+
+    Entry& operator*() const {
+      return *slot;
+    }
+    Entry* operator->() const {
+      return slot;
+    }
+    IteratorImpl& operator++() {
+      ++ctrl;
+      ++slot;
+      skip_free();
+      return *this;
+    }
+    IteratorImpl operator++(int) {
+      auto copy = *this;
+      ++(*this);
+      return copy;
+    }
+    friend bool operator==(const IteratorImpl& lhs, const IteratorImpl& rhs) {
+      return lhs.ctrl == rhs.ctrl;
+    }
+    friend bool operator!=(const IteratorImpl& lhs, const IteratorImpl& rhs) {
+      return lhs.ctrl != rhs.ctrl;
+    }
+
+  private:
+    friend class flat_hash_map;
+
+    void skip_free() {
+      while (ctrl != end && *ctrl < 0) {
+        ++ctrl;
+        ++slot;
+      }
+    }
+
+    const int8_t* ctrl = nullptr;
+    Entry* slot = nullptr;
+    const int8_t* end = nullptr;
+  };
+  using Iterator = IteratorImpl<false>;
+  using ConstIterator = IteratorImpl<true>;
+
+  flat_hash_map() = default;
+  ~flat_hash_map() {
+    destroy();
+  }
+  flat_hash_map(const flat_hash_map& rhs) {
+    reserve(rhs.size());
+    for (const auto& entry : rhs)
+      insert(entry.first, entry.second);
+  }
+  flat_hash_map(flat_hash_map&& rhs) {
+    take(rhs);
+  }
+  flat_hash_map& operator=(flat_hash_map rhs) {
+    destroy();
+    take(rhs);
+    return *this;
+  }
+
+  size_t size() const {
+    return size_;
+  }
+  bool empty() const {
+    return size_ == 0;
+  }
+  size_t capacity() const {
+    return capacity_;
+  }
+
+  Iterator begin() {
+    return {ctrl, slots, ctrl + capacity_};
+  }
+  Iterator end() {
+    return {ctrl + capacity_, slots + capacity_, ctrl + capacity_};
+  }
+  ConstIterator begin() const {
+    return {ctrl, slots, ctrl + capacity_};
+  }
+  ConstIterator end() const {
+    return {ctrl + capacity_, slots + capacity_, ctrl + capacity_};
+  }
+
+  template <typename K>
+  Iterator find(const K& key) {
+    auto i = find_index(key, hash(key));
+    return i == npos ? end() : iterator_at(i);
+  }
+  template <typename K>
+  ConstIterator find(const K& key) const {
+    auto i = find_index(key, hash(key));
+    return i == npos ? end() : iterator_at(i);
+  }
+  template <typename K>
+  bool contains(const K& key) const {
+    return find_index(key, hash(key)) != npos;
+  }
+
+  // Insert `Value(args...)` under `key` unless the key is already present
+  template <typename K, typename... Args>
+  pair<Iterator, bool> try_emplace(K&& key, Args&&... args) {
+    auto h = hash(key);
+    if (auto i = find_index(key, h); i != npos)
+      return {iterator_at(i), false};
+
+    auto i = prepare_insert(h);
+    psl::construct_at(slots + i, Key(FWD(key)), Value(FWD(args)...));
+    return {iterator_at(i), true};
+  }
+  template <typename K, typename V>
+  pair<Iterator, bool> insert(K&& key, V&& value) {
+    return try_emplace(FWD(key), FWD(value));
+  }
+  // Insert or overwrite
+  template <typename K, typename V>
+  Iterator insert_or_assign(K&& key, V&& value) {
+    auto [it, inserted] = try_emplace(FWD(key), FWD(value));
+    if (!inserted)
+      it->second = FWD(value);
+    return it;
+  }
+  template <typename K>
+  Value& operator[](K&& key) {
+    return try_emplace(FWD(key)).first->second;
+  }
+
+  template <typename K>
+  bool erase(const K& key) {
+    auto i = find_index(key, hash(key));
+    if (i == npos)
+      return false;
+    erase_index(i);
+    return true;
+  }
+  void erase(Iterator it) {
+    erase(ConstIterator(it));
+  }
+  void erase(ConstIterator it) {
+    psl_check(it != end());
+    erase_index(it.ctrl - ctrl);
+  }
+
+  void clear() {
+    for (size_t i = 0; i < capacity_; i++)
+      if (ctrl[i] >= 0)
+        psl::destruct_at(slots + i);
+    psl::memset(ctrl, _ctrl_empty, capacity_);
+    size_ = 0;
+    growth_left = max_load(capacity_);
+  }
+
+  // Make room for `n` entries without growing again
+  void reserve(size_t n) {
+    auto cap = capacity_for(n);
+    if (cap > capacity_)
+      rehash(cap);
+  }
+
+private:
+  static constexpr size_t npos = size_t(-1);
+
+  static size_t max_load(size_t cap) {
+    return cap - cap / 8;
+  }
+  static size_t capacity_for(size_t n) {
+    auto cap = group_width;
+    while (max_load(cap) < n)
+      cap *= 2;
+    return cap;
+  }
+  static size_t slots_offset(size_t cap) {
+    return (cap + alignof(value_type) - 1) / alignof(value_type) * alignof(value_type);
+  }
+  static constexpr std::align_val_t alignment() {
+    return std::align_val_t(alignof(value_type) > group_width ? alignof(value_type) : group_width);
+  }
+
+  template <typename K>
+  uint64_t hash(const K& key) const {
+    return hash_fn(key);
+  }
+  static int8_t h2(uint64_t h) {
+    return int8_t(h & 0x7f);
+  }
+
+  Iterator iterator_at(size_t i) {
+    return {ctrl + i, slots + i, ctrl + capacity_};
+  }
+  ConstIterator iterator_at(size_t i) const {
+    return {ctrl + i, slots + i, ctrl + capacity_};
+  }
+
+  // Groups are visited in triangular order, which reaches every group of a power-of-two table.
+  // `visit` returns true to stop
+  template <typename F>
+  void probe(uint64_t h, F&& visit) const {
+    auto group_mask = capacity_ / group_width - 1;
+    auto g = (h >> 7) & group_mask;
+    for (size_t step = 1;; step++) {
+      if (visit(g * group_width, _swiss_group(ctrl + g * group_width)))
+        return;
+      g = (g + step) & group_mask;
+    }
+  }
+
+  template <typename K>
+  size_t find_index(const K& key, uint64_t h) const {
+    if (capacity_ == 0)
+      return npos;
+    auto found = npos;
+    probe(h, [&](size_t base, _swiss_group group) {
+      for (auto mask = group.match(h2(h)); mask; mask &= mask - 1) {
+        auto i = base + __builtin_ctz(mask);
+        if (slots[i].first == key) {
+          found = i;
+          return true;
+        }
+      }
+      return group.match_empty() != 0;
+    });
+    return found;
+  }
+
+  size_t find_free(uint64_t h) const {
+    auto found = npos;
+    probe(h, [&](size_t base, _swiss_group group) {
+      if (auto mask = group.match_free())
+        found = base + __builtin_ctz(mask);
+      return found != npos;
+    });
+    return found;
+  }
+
+  // Claim a free slot for hash `h`, growing the table if it's out of empty slots
+  size_t prepare_insert(uint64_t h) {
+    auto i = capacity_ ? find_free(h) : npos;
+    if (i == npos || (growth_left == 0 && ctrl[i] == _ctrl_empty)) {
+      // Drop tombstones without growing if they are what fills the table
+      rehash(capacity_ && size_ < max_load(capacity_) / 2 ? capacity_ : capacity_for(size_ + 1));
+      i = find_free(h);
+    }
+    if (ctrl[i] == _ctrl_empty)
+      growth_left--;
+    ctrl[i] = h2(h);
+    size_++;
+    return i;
+  }
+
+  // A slot can become empty again only if its group already has an empty slot, because then no
+  // probe sequence ever went past this group
+  void erase_index(size_t i) {
+    psl::destruct_at(slots + i);
+    auto base = i / group_width * group_width;
+    if (_swiss_group(ctrl + base).match_empty()) {
+      ctrl[i] = _ctrl_empty;
+      growth_left++;
+    } else {
+      ctrl[i] = _ctrl_deleted;
+    }
+    size_--;
+  }
+
+  void rehash(size_t cap) {
+    auto old_ctrl = ctrl;
+    auto old_slots = slots;
+    auto old_capacity = capacity_;
+
+    auto memory = (char*)::operator new(slots_offset(cap) + cap * sizeof(value_type), alignment());
+    ctrl = (int8_t*)memory;
+    slots = (value_type*)(memory + slots_offset(cap));
+    capacity_ = cap;
+    psl::memset(ctrl, _ctrl_empty, cap);
+
+    for (size_t i = 0; i < old_capacity; i++) {
+      if (old_ctrl[i] < 0)
+        continue;
+      auto h = hash(old_slots[i].first);
+      auto j = find_free(h);
+      ctrl[j] = h2(h);
+      psl::relocate(slots + j, old_slots + i, 1);
+    }
+    growth_left = max_load(cap) - size_;
+
+    if (old_ctrl)
+      ::operator delete(old_ctrl, alignment());
+  }
+
+  void destroy() {
+    if (!ctrl)
+      return;
+    for (size_t i = 0; i < capacity_; i++)
+      if (ctrl[i] >= 0)
+        psl::destruct_at(slots + i);
+    ::operator delete(ctrl, alignment());
+    ctrl = nullptr;
+    slots = nullptr;
+    capacity_ = size_ = growth_left = 0;
+  }
+
+  void take(flat_hash_map& rhs) {
+    ctrl = psl::exchange(rhs.ctrl, nullptr);
+    slots = psl::exchange(rhs.slots, nullptr);
+    capacity_ = psl::exchange(rhs.capacity_, 0);
+    size_ = psl::exchange(rhs.size_, 0);
+    growth_left = psl::exchange(rhs.growth_left, 0);
+  }
+
+  int8_t* ctrl = nullptr;
+  value_type* slots = nullptr;
+  size_t capacity_ = 0;
+  size_t size_ = 0;
+  size_t growth_left = 0;
+  [[no_unique_address]] Hash hash_fn;
+};
+
+}  // namespace psl
@@ -0,0 +1,204 @@
+#pragma once
+
+#include <psl/algorithm.h>
+#include <psl/vector.h>
+
+namespace psl {
+
+// Entries kept sorted by key in one contiguous vector.
+// Lookups are binary searches over that vector and iteration is a linear scan, which beats the
+// node-based `psl::map` for tables that are built once and read often. Inserting or erasing a
+// single entry shifts the entries after it, so build large tables in bulk instead
+template <typename Entry, typename KeyOf, typename Pred>
+class _flat_tree {
+public:
+  using ValueType = Entry;
+  using Iterator = typename vector<Entry>::Iterator;
+  using ConstIterator = typename vector<Entry>::ConstIterator;
+
+  _flat_tree() = default;
+  // Sort `entries` once and drop duplicated keys; which of the duplicates is kept is unspecified
+  explicit _flat_tree(vector<Entry> entries, Pred comp = {})
+      : entries(psl::move(entries)), comp(psl::move(comp)) {
+    psl::sort(this->entries, [this](const Entry& a, const Entry& b) {
+      return this->comp(key_of(a), key_of(b));
+    });
+    dedup();
+  }
+
+  size_t size() const {
+    return entries.size();
+  }
+  bool empty() const {
+    return entries.size() == 0;
+  }
+  void clear() {
+    entries.clear();
+  }
+  void reserve(size_t n) {
+    entries.reserve(n);
+  }
+
+  Iterator begin() {
+    return entries.begin();
+  }
+  Iterator end() {
+    return entries.end();
+  }
+  ConstIterator begin() const {
+    return entries.begin();
+  }
+  ConstIterator end() const {
+    return entries.end();
+  }
+
+  // The first entry whose key is not less than `key`
+  template <typename K>
+  Iterator lower_bound(const K& key) {
+    return psl::lower_bound(entries, [&](const Entry& x) { return comp(key_of(x), key); });
+  }
+  template <typename K>
+  ConstIterator lower_bound(const K& key) const {
+    return psl::lower_bound(entries, [&](const Entry& x) { return comp(key_of(x), key); });
+  }
+  // The first entry whose key is greater than `key`
+  template <typename K>
+  Iterator upper_bound(const K& key) {
+    return psl::lower_bound(entries, [&](const Entry& x) { return !comp(key, key_of(x)); });
+  }
+  template <typename K>
+  ConstIterator upper_bound(const K& key) const {
+    return psl::lower_bound(entries, [&](const Entry& x) { return !comp(key, key_of(x)); });
+  }
+
+  template <typename K>
+  Iterator find(const K& key) {
+    auto it = lower_bound(key);
+    return it != end() && !comp(key, key_of(*it)) ? it : end();
+  }
+  template <typename K>
+  ConstIterator find(const K& key) const {
+    auto it = lower_bound(key);
+    return it != end() && !comp(key, key_of(*it)) ? it : end();
+  }
+  template <typename K>
+  bool contains(const K& key) const {
+    return find(key) != end();
+  }
+
+  template <typename K>
+  bool erase(const K& key) {
+    auto it = find(key);
+    if (it == end())
+      return false;
+    entries.erase(it);
+    return true;
+  }
+  void erase(Iterator it) {
+    entries.erase(it);
+  }
+
+  // The underlying sorted vector
+  const vector<Entry>& data() const {
+    return entries;
+  }
+
+protected:
+  static decltype(auto) key_of(const Entry& x) {
+    return KeyOf()(x);
+  }
+
+  // Insert the entry made by `make()` at the position of `key`, unless the key is present
+  template <typename K, typename F>
+  pair<Iterator, bool> insert_at(const K& key, F&& make) {
+    auto it = lower_bound(key);
+    if (it != end() && !comp(key, key_of(*it)))
+      return {it, false};
+    return {entries.insert(it, make()), true};
+  }
+
+  void dedup() {
+    if (entries.size() < 2)
+      return;
+    size_t tail = 1;
+    for (size_t i = 1; i < entries.size(); i++)
+      if (comp(key_of(entries[tail - 1]), key_of(entries[i]))) {
+        if (i != tail)
+          entries[tail] = psl::move(entries[i]);
+        tail++;
+      }
+    entries.resize_less(tail);
+  }
+
+  vector<Entry> entries;
+  [[no_unique_address]] Pred comp;
+};
+
+struct _first_of_entry {
+  template <typename T>
+  const auto& operator()(const T& x) const {
+    return x.first;
+  }
+};
+struct _entry_itself {
+  template <typename T>
+  const T& operator()(const T& x) const {
+    return x;
+  }
+};
+
+template <typename Key, typename Value, typename Pred = less<>>
+class flat_map : public _flat_tree<pair<Key, Value>, _first_of_entry, Pred> {
+  using Base = _flat_tree<pair<Key, Value>, _first_of_entry, Pred>;
+
+public:
+  using value_type = Value;
+  using typename Base::Iterator;
+
+  using Base::Base;
+  template <Range ARange>
+  requires(!SameAs<Decay<ARange>, flat_map>)
+  explicit flat_map(ARange&& range, Pred comp = {})
+      : Base(vector<pair<Key, Value>>(FWD(range)), psl::move(comp)) {
+  }
+
+  template <typename K, typename V>
+  pair<Iterator, bool> insert(K&& key, V&& value) {
+    return this->insert_at(key, [&] { return pair<Key, Value>(Key(FWD(key)), Value(FWD(value))); });
+  }
+  template <typename K, typename V>
+  Iterator insert_or_assign(K&& key, V&& value) {
+    auto [it, inserted] = insert(FWD(key), FWD(value));
+    if (!inserted)
+      it->second = FWD(value);
+    return it;
+  }
+  template <typename K>
+  Value& operator[](K&& key) {
+    return this->insert_at(key, [&] { return pair<Key, Value>(Key(FWD(key)), Value()); })
+        .first->second;
+  }
+};
+
+template <typename Value, typename Pred = less<>>
+class flat_set : public _flat_tree<Value, _entry_itself, Pred> {
+  using Base = _flat_tree<Value, _entry_itself, Pred>;
+
+public:
+  using value_type = Value;
+  using typename Base::Iterator;
+
+  using Base::Base;
+  template <Range ARange>
+  requires(!SameAs<Decay<ARange>, flat_set>)
+  explicit flat_set(ARange&& range, Pred comp = {})
+      : Base(vector<Value>(FWD(range)), psl::move(comp)) {
+  }
+
+  template <typename V>
+  pair<Iterator, bool> insert(V&& value) {
+    return this->insert_at(value, [&] { return Value(FWD(value)); });
+  }
+};
+
+}  // namespace psl
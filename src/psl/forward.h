@@ -11,12 +11,16 @@ template <typename Key, typename Value, typename Pred>
 struct map;
 template <typename Key, typename Value, typename Pred>
 struct multimap;
+template <typename Key, typename Value, typename Pred>
+class flat_map;
+template <typename Value, typename Pred>
+class flat_set;
 
 template <typename T>
 struct default_deleter;
 template <typename T, typename Deleter>
 class unique_ptr;
-template <typename T>
+template <typename T, typename Deleter, bool atomic_refcount>
 class shared_ptr;
 
 template <typename T>
@@ -32,11 +36,15 @@ template <typename Key, typename Value>
 struct unordered_map;
 template <typename Key, typename Value>
 struct unordered_multimap;
+template <typename T>
+struct hasher;
+template <typename Key, typename Value, typename Hash>
+class flat_hash_map;
 
 template <typename... Ts>
 struct variant;
 
-template <typename T>
+template <typename T, typename Growth>
 struct default_allocator;
 template <typename T, size_t capacity>
 struct static_allocator;
@@ -45,6 +53,8 @@ template <typename T, typename Allocator>
 class vector;
 template <typename T, size_t capacity>
 struct static_vector;
+template <typename T, size_t block_size>
+class colony;
 
 template <typename... Us, typename... Ts>
 auto vector_of(Ts... xs);
@@ -6,34 +6,173 @@ namespace psl {
 template <typename T>
 class function;
 
+// Callables of up to `inline_size` bytes that can be copied are stored inline and dispatched
+// through a static table of function pointers; anything else is kept on the heap and shared
+// between copies. With the table and the call thunk a function is 48 bytes, which keeps copies
+// cheaper than std::function's and leaves room for four captured pointers
 template <typename R, typename... Args>
 class function<R(Args...)> {
-  struct FunctionConcept {
-    virtual ~FunctionConcept() = default;
-    virtual R call(Args... args) const = 0;
+public:
+  static constexpr size_t inline_size = 32;
+  static constexpr size_t inline_alignment = 16;
+
+private:
+  // `copy`, `relocate` and `destroy` are null for trivially copyable callables,
+  // whose bytes are copied instead. The call thunk is kept in the function itself to save a load
+  using Thunk = R (*)(const void* f, Args... args);
+  struct VTable {
+    void (*copy)(void* dst, const void* src);
+    void (*relocate)(void* dst, void* src);
+    void (*destroy)(void* f);
   };
-  template <typename F>
-  struct FunctionModel : FunctionConcept {
-    FunctionModel(F f) : f(psl::move(f)) {
-    }
 
-    R call(Args... args) const override {
-      return f(static_cast<Args>(args)...);
+  template <typename F>
+  struct SharedModel {
+    R operator()(Args... args) const {
+      return (*f)(static_cast<Args>(args)...);
     }
-    F f;
+    shared_ptr<F> f;
   };
-  shared_ptr<const FunctionConcept> model;
+
+  template <typename F>
+  static constexpr bool stored_inline = sizeof(F) <= inline_size &&
+                                        alignof(F) <= inline_alignment && copyable<F>;
+
+  template <typename F>
+  static R call(const void* f, Args... args) {
+    return (*static_cast<const F*>(f))(static_cast<Args>(args)...);
+  }
+  template <typename F>
+  static constexpr VTable vtable_for = {
+      __is_trivially_copyable(F) ? nullptr : +[](void* dst, const void* src) {
+        psl::construct_at(static_cast<F*>(dst), *static_cast<const F*>(src));
+      },
+      __is_trivially_copyable(F) ? nullptr : +[](void* dst, void* src) {
+        psl::construct_at(static_cast<F*>(dst), psl::move(*static_cast<F*>(src)));
+        psl::destruct_at(static_cast<F*>(src));
+      },
+      __is_trivially_copyable(F) ? nullptr : +[](void* f) {
+        psl::destruct_at(static_cast<F*>(f));
+      }};
 
 public:
   using ReturnType = R;
   function() = default;
   template <typename F>
   requires requires(F f, Args... args) { f(args...); }
-  function(F f) : model(psl::make_shared<FunctionModel<F>>(MOVE(f))) {
+  function(F f) {
+    if constexpr (stored_inline<F>) {
+      psl::construct_at(storage.template ptr<F>(), MOVE(f));
+      vtable = &vtable_for<F>;
+      thunk = &call<F>;
+    } else {
+      psl::construct_at(storage.template ptr<SharedModel<F>>(),
+                        SharedModel<F>{psl::make_shared<F>(MOVE(f))});
+      vtable = &vtable_for<SharedModel<F>>;
+      thunk = &call<SharedModel<F>>;
+    }
+  }
+
+  ~function() {
+    reset();
+  }
+  function(const function& rhs) {
+    copy(rhs);
+  }
+  function(function&& rhs) {
+    take(rhs);
+  }
+  function& operator=(const function& rhs) {
+    if (this != &rhs) {
+      reset();
+      copy(rhs);
+    }
+    return *this;
+  }
+  function& operator=(function&& rhs) {
+    if (this != &rhs) {
+      reset();
+      take(rhs);
+    }
+    return *this;
+  }
+
+  R operator()(Args... args) const {
+    return thunk(storage.ptr(), static_cast<Args>(args)...);
+  }
+
+  explicit operator bool() const {
+    return vtable != nullptr;
+  }
+
+  void reset() {
+    if (vtable && vtable->destroy)
+      vtable->destroy(storage.ptr());
+    vtable = nullptr;
+    thunk = nullptr;
+  }
+
+private:
+  void copy(const function& rhs) {
+    if (rhs.vtable && rhs.vtable->copy)
+      rhs.vtable->copy(storage.ptr(), rhs.storage.ptr());
+    else
+      storage = rhs.storage;
+    vtable = rhs.vtable;
+    thunk = rhs.thunk;
+  }
+  void take(function& rhs) {
+    if (rhs.vtable && rhs.vtable->relocate)
+      rhs.vtable->relocate(storage.ptr(), rhs.storage.ptr());
+    else
+      storage = rhs.storage;
+    vtable = psl::exchange(rhs.vtable, nullptr);
+    thunk = psl::exchange(rhs.thunk, nullptr);
+  }
+
+  Storage<inline_size, inline_alignment> storage = {};
+  const VTable* vtable = nullptr;
+  Thunk thunk = nullptr;
+};
+
+// A non-owning reference to a callable, two pointers wide.
+// The callable must outlive the function_ref, so it's meant for parameters, not for storage
+template <typename T>
+class function_ref;
+
+template <typename R, typename... Args>
+class function_ref<R(Args...)> {
+public:
+  template <typename F>
+  requires(!SameAs<Decay<F>, function_ref> && requires(F f, Args... args) { f(args...); })
+  function_ref(F&& f) {
+    if constexpr (is_function<Decay<F>>) {
+      // Functions are referred to by their address rather than by the variable holding it
+      using Fn = Decay<F>;
+      callee.fn = reinterpret_cast<void (*)()>(static_cast<Fn>(f));
+      thunk = [](Callee callee, Args... args) -> R {
+        return reinterpret_cast<Fn>(callee.fn)(static_cast<Args>(args)...);
+      };
+    } else {
+      callee.object = (void*)&f;
+      thunk = [](Callee callee, Args... args) -> R {
+        return (*static_cast<RemoveReference<F>*>(callee.object))(static_cast<Args>(args)...);
+      };
+    }
   }
+
   R operator()(Args... args) const {
-    return model->call(static_cast<Args>(args)...);
+    return thunk(callee, static_cast<Args>(args)...);
   }
+
+private:
+  union Callee {
+    void* object;
+    void (*fn)();
+  };
+
+  Callee callee;
+  R (*thunk)(Callee callee, Args... args);
 };
 
 template <typename T>
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <psl/type_traits.h>
+#include <psl/memory.h>
+
+namespace psl {
+
+inline uint64_t murmur_hash64A(const unsigned char *key, size_t len, uint64_t seed) {
+  const uint64_t m = 0xc6a4a7935bd1e995ull;
+  const int r = 47;
+
+  uint64_t h = seed ^ (len * m);
+
+  const unsigned char *end = key + 8 * (len / 8);
+
+  while (key != end) {
+    uint64_t k;
+    psl::memcpy(&k, key, sizeof(uint64_t));
+    key += 8;
+
+    k *= m;
+    k ^= k >> r;
+    k *= m;
+
+    h ^= k;
+    h *= m;
+  }
+
+  switch (len & 7) {
+    case 7: h ^= uint64_t(key[6]) << 48; [[fallthrough]];
+    case 6: h ^= uint64_t(key[5]) << 40; [[fallthrough]];
+    case 5: h ^= uint64_t(key[4]) << 32; [[fallthrough]];
+    case 4: h ^= uint64_t(key[3]) << 24; [[fallthrough]];
+    case 3: h ^= uint64_t(key[2]) << 16; [[fallthrough]];
+    case 2: h ^= uint64_t(key[1]) << 8; [[fallthrough]];
+    case 1: h ^= uint64_t(key[0]); h *= m;
+  };
+
+  h ^= h >> r;
+  h *= m;
+  h ^= h >> r;
+
+  return h;
+}
+
+inline uint64_t mix_bits(uint64_t v) {
+  v ^= (v >> 31);
+  v *= 0x7fb5d329728ea185;
+  v ^= (v >> 27);
+  v *= 0x81dadef4bc2dd44d;
+  v ^= (v >> 33);
+  return v;
+}
+
+// Integers, enums and pointers are mixed with `mix_bits`; floats are hashed by value, so 0 and -0
+// collide; contiguous ranges such as strings hash their elements' bytes; anything else must have a
+// unique object representation and is hashed byte by byte.
+// Specialize it for other key types
+template <typename T>
+struct hasher {
+  uint64_t operator()(const T &x) const {
+    if constexpr (is_floating_point<T>) {
+      if (x == 0)
+        return 0;
+      if constexpr (sizeof(T) == 4)
+        return mix_bits(psl::bitcast<uint32_t>(x));
+      else
+        return mix_bits(psl::bitcast<uint64_t>(x));
+    } else if constexpr (is_pointer<T>) {
+      return mix_bits(uint64_t(uintptr_t(x)));
+    } else if constexpr (requires { static_cast<uint64_t>(x); }) {
+      return mix_bits(static_cast<uint64_t>(x));
+    } else if constexpr (requires { x.data() + x.size(); }) {
+      return murmur_hash64A((const unsigned char *)x.data(), x.size() * sizeof(*x.data()), 0);
+    } else {
+      static_assert(__has_unique_object_representations(T),
+                    "hasher<T> needs a specialization for types with padding or indirection");
+      return murmur_hash64A((const unsigned char *)&x, sizeof(T), 0);
+    }
+  }
+};
+
+}  // namespace psl
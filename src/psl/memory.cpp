@@ -1,5 +1,6 @@
 #include <psl/memory.h>
 #include <psl/vector.h>
+#include <psl/cpu.h>
 
 #include <stdlib.h>
 
@@ -8,6 +9,230 @@ void free(void* ptr) {
   ::free(ptr);
 }
 
+// All kernels below handle `size > 16`.
+// The head and tail blocks are loaded before anything is stored, and every block is loaded before
+// it is stored, so the forward kernels are also safe for `memmove` as long as `dst <= src`
+namespace {
+
+using CopyFn = void (*)(char* dst, const char* src, size_t size);
+using SetFn = void (*)(char* dst, char value, size_t size);
+
+#ifdef PSL_X86
+// Beyond this size the destination is unlikely to be read again soon, so stores bypass the cache
+constexpr size_t non_temporal_threshold = size_t(4) << 20;
+
+void copy_forward_sse2(char* dst, const char* src, size_t size) {
+  auto head = _mm_loadu_si128((const __m128i*)src);
+  auto tail = _mm_loadu_si128((const __m128i*)(src + size - 16));
+  auto i = size_t(16);
+  for (; i + 64 < size; i += 64) {
+    auto a = _mm_loadu_si128((const __m128i*)(src + i));
+    auto b = _mm_loadu_si128((const __m128i*)(src + i + 16));
+    auto c = _mm_loadu_si128((const __m128i*)(src + i + 32));
+    auto d = _mm_loadu_si128((const __m128i*)(src + i + 48));
+    _mm_storeu_si128((__m128i*)(dst + i), a);
+    _mm_storeu_si128((__m128i*)(dst + i + 16), b);
+    _mm_storeu_si128((__m128i*)(dst + i + 32), c);
+    _mm_storeu_si128((__m128i*)(dst + i + 48), d);
+  }
+  for (; i + 16 < size; i += 16)
+    _mm_storeu_si128((__m128i*)(dst + i), _mm_loadu_si128((const __m128i*)(src + i)));
+  _mm_storeu_si128((__m128i*)dst, head);
+  _mm_storeu_si128((__m128i*)(dst + size - 16), tail);
+}
+void copy_backward_sse2(char* dst, const char* src, size_t size) {
+  auto head = _mm_loadu_si128((const __m128i*)src);
+  auto tail = _mm_loadu_si128((const __m128i*)(src + size - 16));
+  auto i = size - 16;
+  for (; i > 64 + 16; i -= 64) {
+    auto a = _mm_loadu_si128((const __m128i*)(src + i - 16));
+    auto b = _mm_loadu_si128((const __m128i*)(src + i - 32));
+    auto c = _mm_loadu_si128((const __m128i*)(src + i - 48));
+    auto d = _mm_loadu_si128((const __m128i*)(src + i - 64));
+    _mm_storeu_si128((__m128i*)(dst + i - 16), a);
+    _mm_storeu_si128((__m128i*)(dst + i - 32), b);
+    _mm_storeu_si128((__m128i*)(dst + i - 48), c);
+    _mm_storeu_si128((__m128i*)(dst + i - 64), d);
+  }
+  for (; i > 16; i -= 16)
+    _mm_storeu_si128((__m128i*)(dst + i - 16), _mm_loadu_si128((const __m128i*)(src + i - 16)));
+  _mm_storeu_si128((__m128i*)dst, head);
+  _mm_storeu_si128((__m128i*)(dst + size - 16), tail);
+}
+void set_sse2(char* dst, char value, size_t size) {
+  auto x = _mm_set1_epi8(value);
+  auto i = size_t(0);
+  for (; i + 64 < size; i += 64) {
+    _mm_storeu_si128((__m128i*)(dst + i), x);
+    _mm_storeu_si128((__m128i*)(dst + i + 16), x);
+    _mm_storeu_si128((__m128i*)(dst + i + 32), x);
+    _mm_storeu_si128((__m128i*)(dst + i + 48), x);
+  }
+  for (; i + 16 < size; i += 16)
+    _mm_storeu_si128((__m128i*)(dst + i), x);
+  _mm_storeu_si128((__m128i*)(dst + size - 16), x);
+}
+
+PSL_AVX2 void copy_forward_avx2(char* dst, const char* src, size_t size) {
+  if (size <= 64)
+    return copy_forward_sse2(dst, src, size);
+  auto head = _mm256_loadu_si256((const __m256i*)src);
+  auto tail = _mm256_loadu_si256((const __m256i*)(src + size - 32));
+  // Align the destination so the main loop never splits a cache line on store
+  auto i = 32 - (uintptr_t(dst) & 31);
+  // An overlapping move, like shifting a vector's elements, writes over lines it has just read
+  auto overlapping = size_t(src - dst) < size;
+  if (size >= non_temporal_threshold && !overlapping) {
+    for (; i + 128 < size; i += 128) {
+      auto a = _mm256_loadu_si256((const __m256i*)(src + i));
+      auto b = _mm256_loadu_si256((const __m256i*)(src + i + 32));
+      auto c = _mm256_loadu_si256((const __m256i*)(src + i + 64));
+      auto d = _mm256_loadu_si256((const __m256i*)(src + i + 96));
+      _mm256_stream_si256((__m256i*)(dst + i), a);
+      _mm256_stream_si256((__m256i*)(dst + i + 32), b);
+      _mm256_stream_si256((__m256i*)(dst + i + 64), c);
+      _mm256_stream_si256((__m256i*)(dst + i + 96), d);
+    }
+    _mm_sfence();
+  } else {
+    for (; i + 128 < size; i += 128) {
+      auto a = _mm256_loadu_si256((const __m256i*)(src + i));
+      auto b = _mm256_loadu_si256((const __m256i*)(src + i + 32));
+      auto c = _mm256_loadu_si256((const __m256i*)(src + i + 64));
+      auto d = _mm256_loadu_si256((const __m256i*)(src + i + 96));
+      _mm256_store_si256((__m256i*)(dst + i), a);
+      _mm256_store_si256((__m256i*)(dst + i + 32), b);
+      _mm256_store_si256((__m256i*)(dst + i + 64), c);
+      _mm256_store_si256((__m256i*)(dst + i + 96), d);
+    }
+  }
+  for (; i + 32 < size; i += 32)
+    _mm256_store_si256((__m256i*)(dst + i), _mm256_loadu_si256((const __m256i*)(src + i)));
+  _mm256_storeu_si256((__m256i*)dst, head);
+  _mm256_storeu_si256((__m256i*)(dst + size - 32), tail);
+}
+PSL_AVX2 void set_avx2(char* dst, char value, size_t size) {
+  if (size <= 64)
+    return set_sse2(dst, value, size);
+  auto x = _mm256_set1_epi8(value);
+  _mm256_storeu_si256((__m256i*)dst, x);
+  auto i = 32 - (uintptr_t(dst) & 31);
+  if (size >= non_temporal_threshold) {
+    for (; i + 128 < size; i += 128) {
+      _mm256_stream_si256((__m256i*)(dst + i), x);
+      _mm256_stream_si256((__m256i*)(dst + i + 32), x);
+      _mm256_stream_si256((__m256i*)(dst + i + 64), x);
+      _mm256_stream_si256((__m256i*)(dst + i + 96), x);
+    }
+    _mm_sfence();
+  } else {
+    for (; i + 128 < size; i += 128) {
+      _mm256_store_si256((__m256i*)(dst + i), x);
+      _mm256_store_si256((__m256i*)(dst + i + 32), x);
+      _mm256_store_si256((__m256i*)(dst + i + 64), x);
+      _mm256_store_si256((__m256i*)(dst + i + 96), x);
+    }
+  }
+  for (; i + 32 < size; i += 32)
+    _mm256_store_si256((__m256i*)(dst + i), x);
+  _mm256_storeu_si256((__m256i*)(dst + size - 32), x);
+}
+
+CopyFn pick_copy_forward() {
+  return has_avx2_fma() ? copy_forward_avx2 : copy_forward_sse2;
+}
+CopyFn pick_copy_backward() {
+  return copy_backward_sse2;
+}
+SetFn pick_set() {
+  return has_avx2_fma() ? set_avx2 : set_sse2;
+}
+#else
+void copy_forward_words(char* dst, const char* src, size_t size) {
+  uint64_t head, tail;
+  __builtin_memcpy(&head, src, 8);
+  __builtin_memcpy(&tail, src + size - 8, 8);
+  for (size_t i = 8; i + 8 < size; i += 8) {
+    uint64_t x;
+    __builtin_memcpy(&x, src + i, 8);
+    __builtin_memcpy(dst + i, &x, 8);
+  }
+  __builtin_memcpy(dst, &head, 8);
+  __builtin_memcpy(dst + size - 8, &tail, 8);
+}
+void copy_backward_words(char* dst, const char* src, size_t size) {
+  uint64_t head, tail;
+  __builtin_memcpy(&head, src, 8);
+  __builtin_memcpy(&tail, src + size - 8, 8);
+  for (size_t i = size - 8; i > 8; i -= 8) {
+    uint64_t x;
+    __builtin_memcpy(&x, src + i - 8, 8);
+    __builtin_memcpy(dst + i - 8, &x, 8);
+  }
+  __builtin_memcpy(dst, &head, 8);
+  __builtin_memcpy(dst + size - 8, &tail, 8);
+}
+void set_words(char* dst, char value, size_t size) {
+  auto x = uint64_t(uint8_t(value)) * 0x0101010101010101ull;
+  for (size_t i = 0; i + 8 < size; i += 8)
+    __builtin_memcpy(dst + i, &x, 8);
+  __builtin_memcpy(dst + size - 8, &x, 8);
+}
+
+CopyFn pick_copy_forward() {
+  return copy_forward_words;
+}
+CopyFn pick_copy_backward() {
+  return copy_backward_words;
+}
+SetFn pick_set() {
+  return set_words;
+}
+#endif
+
+// The kernels are picked on first use, which also covers calls made during static initialization.
+// Threads may race to resolve a kernel; they all store the same pointer, and a pointer to code
+// publishes nothing else, so relaxed accesses are enough
+void resolve_copy_forward(char* dst, const char* src, size_t size);
+void resolve_copy_backward(char* dst, const char* src, size_t size);
+void resolve_set(char* dst, char value, size_t size);
+atomic<CopyFn> copy_forward = resolve_copy_forward;
+atomic<CopyFn> copy_backward = resolve_copy_backward;
+atomic<SetFn> set_bytes = resolve_set;
+void resolve_copy_forward(char* dst, const char* src, size_t size) {
+  auto fn = pick_copy_forward();
+  copy_forward.store(fn, memory_order::relaxed);
+  fn(dst, src, size);
+}
+void resolve_copy_backward(char* dst, const char* src, size_t size) {
+  auto fn = pick_copy_backward();
+  copy_backward.store(fn, memory_order::relaxed);
+  fn(dst, src, size);
+}
+void resolve_set(char* dst, char value, size_t size) {
+  auto fn = pick_set();
+  set_bytes.store(fn, memory_order::relaxed);
+  fn(dst, value, size);
+}
+
+}  // namespace
+
+void _memcpy_large(void* dst, const void* src, size_t size) {
+  copy_forward.load(memory_order::relaxed)(static_cast<char*>(dst), static_cast<const char*>(src),
+                                            size);
+}
+void _memmove_large(void* dst, const void* src, size_t size) {
+  auto cdst = static_cast<char*>(dst);
+  auto csrc = static_cast<const char*>(src);
+  if (size_t(cdst - csrc) >= size)
+    copy_forward.load(memory_order::relaxed)(cdst, csrc, size);
+  else
+    copy_backward.load(memory_order::relaxed)(cdst, csrc, size);
+}
+void _memset_large(void* dst, char value, size_t size) {
+  set_bytes.load(memory_order::relaxed)(static_cast<char*>(dst), value, size);
+}
+
 auto allocators = psl::vector_of<pm_allocator>(global_allocator());
 
 void push_context_allocator(pm_allocator allocator) {
@@ -4,6 +4,7 @@
 #include <psl/utility.h>
 #include <psl/stdint.h>
 #include <psl/new.h>
+#include <psl/atomic.h>
 
 namespace psl {
 
@@ -27,17 +28,112 @@ void context_delete(T* ptr) {
 void push_context_allocator(struct pm_allocator allocator);
 void pop_context_allocator();
 
-inline constexpr void memcpy(void* dst, const void* src, size_t size) {
+void _memcpy_large(void* dst, const void* src, size_t size);
+void _memmove_large(void* dst, const void* src, size_t size);
+void _memset_large(void* dst, char value, size_t size);
+
+// Copies of at most 16 bytes are done with two possibly overlapping word-sized loads and stores,
+// which fold into plain moves when `size` is known at compile time
+inline void _memmove_small(void* dst, const void* src, size_t size) {
   auto csrc = static_cast<const char*>(src);
   auto cdst = static_cast<char*>(dst);
-  for (size_t i = 0; i != size; i++)
-    cdst[i] = csrc[i];
+  if (size >= 8) {
+    uint64_t a, b;
+    __builtin_memcpy(&a, csrc, 8);
+    __builtin_memcpy(&b, csrc + size - 8, 8);
+    __builtin_memcpy(cdst, &a, 8);
+    __builtin_memcpy(cdst + size - 8, &b, 8);
+  } else if (size >= 4) {
+    uint32_t a, b;
+    __builtin_memcpy(&a, csrc, 4);
+    __builtin_memcpy(&b, csrc + size - 4, 4);
+    __builtin_memcpy(cdst, &a, 4);
+    __builtin_memcpy(cdst + size - 4, &b, 4);
+  } else if (size >= 2) {
+    uint16_t a, b;
+    __builtin_memcpy(&a, csrc, 2);
+    __builtin_memcpy(&b, csrc + size - 2, 2);
+    __builtin_memcpy(cdst, &a, 2);
+    __builtin_memcpy(cdst + size - 2, &b, 2);
+  } else if (size == 1) {
+    *cdst = *csrc;
+  }
+}
+
+inline constexpr void memcpy(void* dst, const void* src, size_t size) {
+  if consteval {
+    auto csrc = static_cast<const char*>(src);
+    auto cdst = static_cast<char*>(dst);
+    for (size_t i = 0; i != size; i++)
+      cdst[i] = csrc[i];
+  } else {
+    if (size <= 16)
+      psl::_memmove_small(dst, src, size);
+    else
+      psl::_memcpy_large(dst, src, size);
+  }
+}
+
+inline constexpr void memmove(void* dst, const void* src, size_t size) {
+  if consteval {
+    auto csrc = static_cast<const char*>(src);
+    auto cdst = static_cast<char*>(dst);
+    if (cdst < csrc)
+      for (size_t i = 0; i != size; i++)
+        cdst[i] = csrc[i];
+    else
+      for (size_t i = size; i != 0; i--)
+        cdst[i - 1] = csrc[i - 1];
+  } else {
+    if (size <= 16)
+      psl::_memmove_small(dst, src, size);
+    else
+      psl::_memmove_large(dst, src, size);
+  }
 }
 
 inline constexpr void memset(void* dst, char value, size_t size) {
-  auto cdst = static_cast<char*>(dst);
-  for (size_t i = 0; i != size; i++)
-    cdst[i] = value;
+  if consteval {
+    auto cdst = static_cast<char*>(dst);
+    for (size_t i = 0; i != size; i++)
+      cdst[i] = value;
+  } else {
+    if (size <= 16) {
+      auto cdst = static_cast<char*>(dst);
+      for (size_t i = 0; i != size; i++)
+        cdst[i] = value;
+    } else {
+      psl::_memset_large(dst, value, size);
+    }
+  }
+}
+
+// Move `n` objects from `src` to uninitialized memory at `dst`, ending the lifetime of the sources
+template <typename T>
+void relocate(T* dst, T* src, size_t n) {
+  if constexpr (psl::is_trivially_relocatable<T>) {
+    psl::memmove(dst, src, n * sizeof(T));
+  } else {
+    for (size_t i = 0; i != n; i++) {
+      psl::construct_at(dst + i, psl::move(src[i]));
+      psl::destruct_at(src + i);
+    }
+  }
+}
+
+// Same as `relocate`, but the two ranges may overlap, as when shifting elements within a buffer
+template <typename T>
+void relocate_overlapping(T* dst, T* src, size_t n) {
+  if constexpr (psl::is_trivially_relocatable<T>) {
+    psl::memmove(dst, src, n * sizeof(T));
+  } else if (dst < src) {
+    psl::relocate(dst, src, n);
+  } else if (dst > src) {
+    for (size_t i = n; i-- != 0;) {
+      psl::construct_at(dst + i, psl::move(src[i]));
+      psl::destruct_at(src + i);
+    }
+  }
 }
 
 void free(void* ptr);
@@ -208,13 +304,30 @@ unique_ptr<T> make_unique(Args&&... args) {
   return unique_ptr<T>(new T(FWD(args)...));
 }
 
-template <typename T, typename Deleter = default_deleter<T>>
+// Shared by every shared_ptr to the same object.
+// `dispose` is set when the object lives in the same allocation as the block, and destroys both
+struct _shared_block {
+  size_t count = 1;
+  void (*dispose)(_shared_block* block) = nullptr;
+};
+template <typename T>
+struct _shared_inplace {
+  T* object() {
+    return (T*)storage;
+  }
+
+  _shared_block block;
+  alignas(T) unsigned char storage[sizeof(T)];
+};
+
+// With `atomic_refcount` the count is updated atomically, so copies can be shared across threads
+template <typename T, typename Deleter = default_deleter<T>, bool atomic_refcount = false>
 class shared_ptr {
 public:
   using Pointer = RemoveExtent<T>*;
   using Reference = RemoveExtent<T>&;
 
-  template <typename U, typename UDeleter>
+  template <typename U, typename UDeleter, bool UAtomic>
   friend class shared_ptr;
 
   ~shared_ptr() {
@@ -226,7 +339,7 @@ public:
   shared_ptr(nullptr_t) {
   }
   explicit shared_ptr(Pointer ptr, Deleter deleter = {})
-      : deleter(deleter), ptr(ptr), refcount(new size_t(1)) {
+      : deleter(deleter), ptr(ptr), block(ptr ? new _shared_block : nullptr) {
   }
 
   shared_ptr(const shared_ptr& rhs) : shared_ptr() {
@@ -241,15 +354,23 @@ public:
   }
 
   template <DerivedFrom<T> U>
-  shared_ptr(shared_ptr<U> rhs) : shared_ptr() {
+  shared_ptr(shared_ptr<U, default_deleter<U>, atomic_refcount> rhs) : shared_ptr() {
     take(rhs);
   }
   template <DerivedFrom<T> U>
-  shared_ptr& operator=(shared_ptr<U> rhs) {
+  shared_ptr& operator=(shared_ptr<U, default_deleter<U>, atomic_refcount> rhs) {
     take(rhs);
     return *this;
   }
 
+  // Adopt a block that already holds a count for `ptr`, used by `make_shared`
+  static shared_ptr _from_block(Pointer ptr, _shared_block* block) {
+    auto p = shared_ptr();
+    p.ptr = ptr;
+    p.block = block;
+    return p;
+  }
+
   Reference operator*() const {
     return *ptr;
   }
@@ -269,28 +390,40 @@ public:
   Pointer get() const {
     return ptr;
   }
+  size_t use_count() const {
+    if (!block)
+      return 0;
+    if constexpr (atomic_refcount)
+      return psl::atomic_load(&block->count, memory_order::relaxed);
+    else
+      return block->count;
+  }
 
   void reset(Pointer p = {}) {
     decrement();
 
     ptr = p;
-    refcount = new size_t(1);
+    block = p ? new _shared_block : nullptr;
   }
 
-  template <typename U>
-  friend bool operator==(const shared_ptr& lhs, const shared_ptr<U>& rhs) {
+  template <typename U, typename UDeleter>
+  friend bool operator==(const shared_ptr& lhs,
+                         const shared_ptr<U, UDeleter, atomic_refcount>& rhs) {
     return lhs.get() == rhs.get();
   }
-  template <typename U>
-  friend bool operator!=(const shared_ptr& lhs, const shared_ptr<U>& rhs) {
+  template <typename U, typename UDeleter>
+  friend bool operator!=(const shared_ptr& lhs,
+                         const shared_ptr<U, UDeleter, atomic_refcount>& rhs) {
     return lhs.get() != rhs.get();
   }
-  template <typename U>
-  friend bool operator>(const shared_ptr& lhs, const shared_ptr<U>& rhs) {
+  template <typename U, typename UDeleter>
+  friend bool operator>(const shared_ptr& lhs,
+                        const shared_ptr<U, UDeleter, atomic_refcount>& rhs) {
     return lhs.get() > rhs.get();
   }
-  template <typename U>
-  friend bool operator<(const shared_ptr& lhs, const shared_ptr<U>& rhs) {
+  template <typename U, typename UDeleter>
+  friend bool operator<(const shared_ptr& lhs,
+                        const shared_ptr<U, UDeleter, atomic_refcount>& rhs) {
     return lhs.get() < rhs.get();
   }
   bool operator==(nullptr_t) const {
@@ -302,49 +435,107 @@ public:
 
 private:
   template <typename U, typename UDeleter>
-  void copy(const shared_ptr<U, UDeleter>& rhs) {
+  void copy(const shared_ptr<U, UDeleter, atomic_refcount>& rhs) {
     decrement();
 
     deleter = rhs.deleter;
     ptr = rhs.ptr;
-    refcount = rhs.refcount;
+    block = rhs.block;
 
-    if (refcount)
-      ++(*refcount);
+    if (block) {
+      if constexpr (atomic_refcount)
+        psl::atomic_fetch_add(&block->count, size_t(1), memory_order::relaxed);
+      else
+        ++block->count;
+    }
   }
 
   template <typename U, typename UDeleter>
-  void take(shared_ptr<U, UDeleter>& rhs) {
+  void take(shared_ptr<U, UDeleter, atomic_refcount>& rhs) {
     decrement();
 
     deleter = psl::move(rhs.deleter);
     ptr = psl::exchange(rhs.ptr, nullptr);
-    refcount = psl::exchange(rhs.refcount, nullptr);
+    block = psl::exchange(rhs.block, nullptr);
   }
 
   void decrement() {
-    if (ptr != Pointer()) {
-      if (--(*refcount) == 0) {
+    if (!block)
+      return;
+    auto last = false;
+    if constexpr (atomic_refcount)
+      last = psl::atomic_fetch_sub(&block->count, size_t(1), memory_order::acq_rel) == 1;
+    else
+      last = --block->count == 0;
+
+    if (last) {
+      if (block->dispose) {
+        block->dispose(block);
+      } else {
         deleter(ptr);
-        ptr = nullptr;
-        delete refcount;
+        delete block;
       }
+      ptr = nullptr;
+      block = nullptr;
     }
   }
 
   Deleter deleter;
   Pointer ptr = nullptr;
-  size_t* refcount = nullptr;
+  _shared_block* block = nullptr;
 };
+
+// Uninitialized room for a `T`, from the context allocator or from `operator new`, which is asked
+// for the alignment of over-aligned types; `_shared_free` gives it back the same way
+template <typename T>
+void* _shared_alloc(bool context) {
+  if (context)
+    return context_alloc(sizeof(T));
+  if constexpr (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+    return ::operator new(sizeof(T), std::align_val_t(alignof(T)));
+  else
+    return ::operator new(sizeof(T));
+}
+template <typename T>
+void _shared_free(T* ptr, bool context) {
+  if (context)
+    context_free(ptr);
+  else if constexpr (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+    ::operator delete(ptr, std::align_val_t(alignof(T)));
+  else
+    ::operator delete(ptr);
+}
+
+// Build a shared pointer whose `dispose` destroys the object and frees the combined block
+template <typename SharedPtr, typename T, bool context, typename... Args>
+SharedPtr _make_shared_inplace(Args&&... args) {
+  using Inplace = _shared_inplace<T>;
+  auto inplace = (Inplace*)_shared_alloc<Inplace>(context);
+  psl::construct_at(&inplace->block);
+  psl::construct_at(inplace->object(), FWD(args)...);
+  inplace->block.dispose = [](_shared_block* block) {
+    auto inplace = (Inplace*)block;
+    psl::destruct_at(inplace->object());
+    _shared_free(inplace, context);
+  };
+  return SharedPtr::_from_block(inplace->object(), &inplace->block);
+}
+
 template <typename T>
 using context_shared_ptr = shared_ptr<T, context_deleter<T>>;
 template <typename T, typename... Args>
 context_shared_ptr<T> make_context_shared(Args&&... args) {
-  return context_shared_ptr<T>(context_new<T>(FWD(args)...));
+  return _make_shared_inplace<context_shared_ptr<T>, T, true>(FWD(args)...);
 }
 template <typename T, typename... Args>
 shared_ptr<T> make_shared(Args&&... args) {
-  return shared_ptr<T>(new T(FWD(args)...));
+  return _make_shared_inplace<shared_ptr<T>, T, false>(FWD(args)...);
+}
+template <typename T>
+using atomic_shared_ptr = shared_ptr<T, default_deleter<T>, true>;
+template <typename T, typename... Args>
+atomic_shared_ptr<T> make_atomic_shared(Args&&... args) {
+  return _make_shared_inplace<atomic_shared_ptr<T>, T, false>(FWD(args)...);
 }
 
 struct pm_allocator {
@@ -369,18 +560,28 @@ struct pm_allocator {
   };
 
   template <typename T>
-  pm_allocator(T x) : model(psl::make_unique<pm_model<T>>(MOVE(x))) {
+  pm_allocator(T x)
+      : model(psl::make_unique<pm_model<T>>(MOVE(x))), noop_free(has_noop_free<T>) {
   }
 
   void* alloc(size_t size) {
     return model->alloc(size);
   }
   void free(void* ptr) {
-    model->free(ptr);
+    if (!noop_free)
+      model->free(ptr);
   }
 
 private:
+  // Allocators that release everything at once declare `static constexpr bool noop_free = true`,
+  // which lets `free` skip the virtual call
+  template <typename T>
+  static constexpr bool has_noop_free = requires {
+    requires T::noop_free;
+  };
+
   unique_ptr<pm_concept> model;
+  bool noop_free;
 };
 
 struct global_allocator {
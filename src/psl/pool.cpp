@@ -0,0 +1,188 @@
+#include <psl/pool.h>
+
+namespace psl {
+
+struct pool_resource::Slab {
+  Slab* next;
+  pool_resource* owner;
+  int size_class;
+};
+static constexpr int large_class = -1;
+
+pool_resource::pool_resource(bool thread_safe) : thread_safe(thread_safe) {
+}
+pool_resource::~pool_resource() {
+  while (slabs) {
+    auto next = slabs->next;
+    ::operator delete(slabs, std::align_val_t(slab_size));
+    slabs = next;
+  }
+}
+
+pool_resource::Slab* pool_resource::slab_of(const void* ptr) {
+  return (Slab*)(uintptr_t(ptr) & ~uintptr_t(slab_size - 1));
+}
+int pool_resource::size_class_of(const void* ptr) {
+  return slab_of(ptr)->size_class;
+}
+pool_resource* pool_resource::owner_of(const void* ptr) {
+  return slab_of(ptr)->owner;
+}
+
+void* pool_resource::alloc(size_t size) {
+  if (size > max_block_size) {
+    // Large blocks get a slab-aligned header of their own so `free` can tell them apart
+    auto slab = (Slab*)::operator new(slab_header_size + size, std::align_val_t(slab_size));
+    slab->next = nullptr;
+    slab->owner = this;
+    slab->size_class = large_class;
+    return (char*)slab + slab_header_size;
+  }
+
+  lock();
+  auto ptr = alloc_local(size_class(size));
+  unlock();
+  return ptr;
+}
+
+void pool_resource::free(void* ptr) {
+  if (!ptr)
+    return;
+  auto slab = slab_of(ptr);
+  if (slab->size_class == large_class) {
+    ::operator delete(slab, std::align_val_t(slab_size));
+    return;
+  }
+
+  auto pool = slab->owner;
+  pool->lock();
+  pool->free_local(slab->size_class, ptr);
+  pool->unlock();
+}
+
+size_t pool_resource::alloc_batch(int c, void** blocks, size_t n) {
+  psl_check(c >= 0 && c < n_classes);
+  lock();
+  for (size_t i = 0; i < n; i++)
+    blocks[i] = alloc_local(c);
+  unlock();
+  return n;
+}
+void pool_resource::free_batch(int c, void* const* blocks, size_t n) {
+  psl_check(c >= 0 && c < n_classes);
+  lock();
+  for (size_t i = 0; i < n; i++)
+    free_local(c, blocks[i]);
+  unlock();
+}
+
+void* pool_resource::alloc_local(int c) {
+  auto& sc = classes[c];
+  if (auto block = sc.free_list) {
+    sc.free_list = block->next;
+    return block;
+  }
+  if (sc.carve == sc.carve_end)
+    new_slab(c);
+  auto ptr = sc.carve;
+  sc.carve += class_size(c);
+  return ptr;
+}
+void pool_resource::free_local(int c, void* ptr) {
+  auto& sc = classes[c];
+  auto block = (FreeBlock*)ptr;
+  block->next = sc.free_list;
+  sc.free_list = block;
+}
+
+void pool_resource::new_slab(int c) {
+  static_assert(sizeof(Slab) <= slab_header_size);
+  auto slab = (Slab*)::operator new(slab_size, std::align_val_t(slab_size));
+  slab->next = slabs;
+  slab->owner = this;
+  slab->size_class = c;
+  slabs = slab;
+
+  // Blocks are carved lazily so a fresh slab costs nothing until it's used
+  auto& sc = classes[c];
+  auto bs = class_size(c);
+  sc.carve = (char*)slab + slab_header_size;
+  sc.carve_end = sc.carve + (slab_size - slab_header_size) / bs * bs;
+}
+
+void pool_resource::lock() {
+  if (thread_safe)
+    while (__atomic_test_and_set(&locked, __ATOMIC_ACQUIRE)) {
+#if defined(__x86_64__) || defined(__i386__)
+      __builtin_ia32_pause();
+#endif
+    }
+}
+void pool_resource::unlock() {
+  if (thread_safe)
+    __atomic_clear(&locked, __ATOMIC_RELEASE);
+}
+
+pool_resource& default_pool() {
+  // Never destroyed, so blocks freed during static destruction still have somewhere to go
+  static auto pool = new pool_resource(true);
+  return *pool;
+}
+
+namespace {
+
+// Set once a thread's cache is destroyed. Thread-local and static destructors that run after it
+// still allocate and free, and they go straight to the default pool. A trivially destructible
+// flag stays readable for the whole life of the thread
+thread_local bool thread_cache_destroyed = false;
+
+// Blocks of the default pool cached by one thread. Refills and flushes move half the capacity at
+// once, so the shared lock is taken once every `capacity / 2` calls at most
+struct ThreadCache {
+  static constexpr size_t capacity = 64;
+
+  ~ThreadCache() {
+    thread_cache_destroyed = true;
+    for (int c = 0; c < pool_resource::n_classes; c++)
+      if (counts[c])
+        default_pool().free_batch(c, blocks[c], counts[c]);
+  }
+
+  void* alloc(int c) {
+    if (counts[c] == 0)
+      counts[c] = default_pool().alloc_batch(c, blocks[c], capacity / 2);
+    return blocks[c][--counts[c]];
+  }
+  void free(int c, void* ptr) {
+    if (counts[c] == capacity) {
+      counts[c] -= capacity / 2;
+      default_pool().free_batch(c, blocks[c] + counts[c], capacity / 2);
+    }
+    blocks[c][counts[c]++] = ptr;
+  }
+
+  void* blocks[pool_resource::n_classes][capacity];
+  size_t counts[pool_resource::n_classes] = {};
+};
+
+thread_local ThreadCache thread_cache;
+
+}  // namespace
+
+void* pool_alloc(size_t size) {
+  if (size > pool_resource::max_block_size || thread_cache_destroyed)
+    return default_pool().alloc(size);
+  return thread_cache.alloc(pool_resource::size_class(size));
+}
+void pool_free(void* ptr) {
+  if (!ptr)
+    return;
+  auto c = pool_resource::size_class_of(ptr);
+  if (c == large_class || pool_resource::owner_of(ptr) != &default_pool() ||
+      thread_cache_destroyed)
+    pool_resource::free(ptr);
+  else
+    thread_cache.free(c, ptr);
+}
+
+}  // namespace psl
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <psl/memory.h>
+#include <psl/check.h>
+
+namespace psl {
+
+// Serves allocations from per-size-class free lists, one class per power of two from 8 B to 4 KiB.
+// Blocks are carved from 64 KiB-aligned slabs whose header records the size class and the owning
+// pool, so `free` needs nothing but the pointer. Larger requests go to the heap behind the same
+// kind of header
+class pool_resource {
+public:
+  static constexpr size_t slab_size = size_t(64) << 10;
+  static constexpr size_t slab_header_size = 64;
+  static constexpr int min_class = 3;
+  static constexpr int max_class = 12;
+  static constexpr int n_classes = max_class - min_class + 1;
+  static constexpr size_t max_block_size = size_t(1) << max_class;
+
+  explicit pool_resource(bool thread_safe = false);
+  ~pool_resource();
+
+  pool_resource(const pool_resource&) = delete;
+  pool_resource& operator=(const pool_resource&) = delete;
+
+  void* alloc(size_t size);
+  // Return `ptr` to the pool that allocated it, whichever that is
+  static void free(void* ptr);
+
+  // Take up to `n` blocks of class `c` in one go, returns the number of blocks taken
+  size_t alloc_batch(int c, void** blocks, size_t n);
+  void free_batch(int c, void* const* blocks, size_t n);
+
+  static int size_class(size_t size) {
+    if (size <= (size_t(1) << min_class))
+      return 0;
+    return 64 - __builtin_clzll(size - 1) - min_class;
+  }
+  static size_t class_size(int c) {
+    return size_t(1) << (c + min_class);
+  }
+  // The size class of a block handed out by any pool, or -1 if it was too large for one
+  static int size_class_of(const void* ptr);
+  static pool_resource* owner_of(const void* ptr);
+
+private:
+  struct Slab;
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+  struct SizeClass {
+    FreeBlock* free_list = nullptr;
+    char* carve = nullptr;
+    char* carve_end = nullptr;
+  };
+
+  static Slab* slab_of(const void* ptr);
+
+  void* alloc_local(int c);
+  void free_local(int c, void* ptr);
+  void new_slab(int c);
+
+  void lock();
+  void unlock();
+
+  SizeClass classes[n_classes];
+  Slab* slabs = nullptr;
+  bool thread_safe;
+  bool locked = false;
+};
+
+// The process-wide pool. It's thread-safe, and each thread keeps a small cache of blocks per size
+// class in front of it, so most calls touch neither the lock nor the heap
+pool_resource& default_pool();
+void* pool_alloc(size_t size);
+void pool_free(void* ptr);
+
+// For `push_context_allocator`
+struct global_pool_allocator {
+  void* alloc(size_t size) {
+    return pool_alloc(size);
+  }
+  void free(void* ptr) {
+    pool_free(ptr);
+  }
+};
+// For `push_context_allocator` with a private pool; the pool must outlive the push
+struct pool_resource_ref {
+  void* alloc(size_t size) {
+    return pool->alloc(size);
+  }
+  void free(void* ptr) {
+    pool_resource::free(ptr);
+  }
+
+  pool_resource* pool;
+};
+
+inline void push_context_allocator(pool_resource& pool) {
+  psl::push_context_allocator(pm_allocator(pool_resource_ref{&pool}));
+}
+
+// For `psl::vector` and other containers taking an `Allocator`
+template <typename T>
+struct pool_allocator {
+  T* alloc(size_t count) const {
+    auto ptr = (T*)pool_alloc(sizeof(T) * count);
+    psl_check(ptr != nullptr);
+    return ptr;
+  }
+  void free(T* ptr) const {
+    if (ptr)
+      pool_free(ptr);
+  }
+
+  template <typename... Args>
+  void construct_at(T* ptr, Args&&... args) const {
+    psl_check(ptr != nullptr);
+    psl::construct_at(ptr, psl::forward<Args>(args)...);
+  }
+
+  void destruct_at(T* ptr) const {
+    psl_check(ptr != nullptr);
+    psl::destruct_at(ptr);
+  }
+};
+
+template <typename T, typename... Args>
+T* pool_new(Args&&... args) {
+  auto ptr = (T*)pool_alloc(sizeof(T));
+  psl::construct_at(ptr, FWD(args)...);
+  return ptr;
+}
+template <typename T>
+void pool_delete(T* ptr) {
+  if (ptr) {
+    ptr->~T();
+    pool_free(ptr);
+  }
+}
+template <typename T>
+struct pool_deleter {
+  pool_deleter() = default;
+  template <DerivedFrom<T> U>
+  pool_deleter(const pool_deleter<U>&) {
+  }
+
+  void operator()(T* ptr) const {
+    pool_delete(ptr);
+  }
+};
+template <typename T>
+using pool_unique_ptr = unique_ptr<T, pool_deleter<T>>;
+template <typename T, typename... Args>
+pool_unique_ptr<T> make_pool_unique(Args&&... args) {
+  return pool_unique_ptr<T>(pool_new<T>(FWD(args)...));
+}
+
+}  // namespace psl
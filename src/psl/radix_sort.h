@@ -0,0 +1,265 @@
+#pragma once
+
+#include <psl/algorithm.h>
+#include <psl/memory.h>
+#include <psl/vector.h>
+#include <psl/thread.h>
+#include <psl/stdint.h>
+
+namespace psl {
+
+// Map a key to an unsigned integer with the same ordering, so that it can be sorted byte by byte
+inline uint32_t radix_key(uint32_t x) {
+  return x;
+}
+inline uint64_t radix_key(uint64_t x) {
+  return x;
+}
+inline uint32_t radix_key(int32_t x) {
+  return uint32_t(x) ^ 0x80000000u;
+}
+inline uint64_t radix_key(int64_t x) {
+  return uint64_t(x) ^ (uint64_t(1) << 63);
+}
+// Negative floats get all their bits flipped, positive ones only the sign bit.
+// -0 sorts before +0 and NaNs sort to either end depending on their sign
+inline uint32_t radix_key(float x) {
+  auto bits = psl::bitcast<uint32_t>(x);
+  return bits ^ (uint32_t(int32_t(bits) >> 31) | 0x80000000u);
+}
+inline uint64_t radix_key(double x) {
+  auto bits = psl::bitcast<uint64_t>(x);
+  return bits ^ (uint64_t(int64_t(bits) >> 63) | (uint64_t(1) << 63));
+}
+
+// Digits are 8 bits for small ranges, where clearing and summing the histograms would cost more
+// than the passes they save, and 11 bits above that, which sorts 32-bit keys in 3 passes and
+// 64-bit keys in 6
+constexpr int _radix_narrow_bits = 8;
+constexpr int _radix_wide_bits = 11;
+constexpr size_t _radix_wide_threshold = size_t(1) << 16;
+// Below this, setting up the histograms costs more than an insertion sort
+constexpr size_t _radix_sort_threshold = 64;
+// A sort of bare keys that still needs this many passes after skipping the constant digits falls
+// back to pdqsort once it is this large: each pass scatters the whole range through memory, and
+// six of them over random 64-bit keys lose to it from about this size on
+constexpr int _radix_max_passes = 5;
+constexpr size_t _radix_fallback_threshold = size_t(1) << 18;
+// Each thread of the parallel sort gets at least this many elements
+constexpr size_t _radix_sort_parallel_grain = size_t(1) << 16;
+
+template <int bits, typename T, typename KeyFn>
+auto _radix_digit(const T& x, KeyFn& key, int pass) {
+  return size_t((radix_key(key(x)) >> (pass * bits)) & ((size_t(1) << bits) - 1));
+}
+
+template <typename Key, int bits>
+constexpr int _radix_passes = (sizeof(Key) * 8 + bits - 1) / bits;
+
+// Move every element of `src` to `dst` at the position its bucket's running offset gives
+template <int bits, typename T, typename KeyFn>
+void _radix_scatter(T* src, T* dst, size_t n, size_t* offsets, KeyFn& key, int pass) {
+  for (size_t i = 0; i < n; i++) {
+    auto& pos = offsets[_radix_digit<bits>(src[i], key, pass)];
+    psl::construct_at(dst + pos++, psl::move(src[i]));
+    psl::destruct_at(src + i);
+  }
+}
+
+// The number of digits that differ between some keys, from the bits that are set in some keys but
+// not in all of them; a quick read that decides the fallback before any histogram is built
+template <int bits, typename T, typename KeyFn>
+int _radix_varying_digits(const T* data, size_t n, KeyFn& key) {
+  using Key = decltype(radix_key(key(*data)));
+  auto any = Key(0), all = ~Key(0);
+  for (size_t i = 0; i < n; i++) {
+    auto k = radix_key(key(data[i]));
+    any |= k;
+    all &= k;
+  }
+  auto varying = Key(any ^ all);
+  int count = 0;
+  for (int p = 0; p < _radix_passes<Key, bits>; p++)
+    if ((varying >> (p * bits)) & ((Key(1) << bits) - 1))
+      count++;
+  return count;
+}
+
+// `keys_only` is set when the elements are their own keys, so that the order of equal ones can't
+// be observed and a comparison sort may stand in
+template <int bits, bool keys_only, typename T, typename KeyFn>
+void _radix_sort_lsd(T* data, size_t n, KeyFn& key) {
+  using Key = decltype(radix_key(key(*data)));
+  constexpr int n_passes = _radix_passes<Key, bits>;
+  constexpr size_t n_buckets = size_t(1) << bits;
+
+  if constexpr (keys_only)
+    if (n >= _radix_fallback_threshold &&
+        _radix_varying_digits<bits>(data, n, key) > _radix_max_passes) {
+      psl::sort(psl::range(data, data + n),
+                [&key](const T& a, const T& b) { return radix_key(key(a)) < radix_key(key(b)); });
+      return;
+    }
+
+  // The histogram of every digit in one read; it doesn't depend on the order of the elements
+  auto counts = psl::vector<size_t>(n_passes * n_buckets);
+  for (size_t i = 0; i < n; i++) {
+    auto k = radix_key(key(data[i]));
+    for (int p = 0; p < n_passes; p++)
+      counts[p * n_buckets + ((k >> (p * bits)) & (n_buckets - 1))]++;
+  }
+
+  // A digit every key shares, like the high bits of small Morton codes, leaves the order as is
+  int passes[n_passes];
+  int n_active = 0;
+  for (int p = 0; p < n_passes; p++)
+    if (counts[p * n_buckets + _radix_digit<bits>(*data, key, p)] != n)
+      passes[n_active++] = p;
+
+  auto buffer = (T*)::operator new(sizeof(T) * n, std::align_val_t(alignof(T)));
+  auto src = data, dst = buffer;
+  for (int i = 0; i < n_active; i++) {
+    auto p = passes[i];
+    auto offsets = &counts[p * n_buckets];
+    for (size_t b = 0, sum = 0; b < n_buckets; b++) {
+      auto count = offsets[b];
+      offsets[b] = sum;
+      sum += count;
+    }
+    _radix_scatter<bits>(src, dst, n, offsets, key, p);
+    psl::swap(src, dst);
+  }
+  if (src != data)
+    for (size_t i = 0; i < n; i++) {
+      psl::construct_at(data + i, psl::move(src[i]));
+      psl::destruct_at(src + i);
+    }
+  ::operator delete(buffer, std::align_val_t(alignof(T)));
+}
+
+template <bool keys_only, typename T, typename KeyFn>
+void _radix_sort(T* data, size_t n, KeyFn& key) {
+  if (n < _radix_sort_threshold) {
+    auto comp = [&key](const T& a, const T& b) { return radix_key(key(a)) < radix_key(key(b)); };
+    psl::_insertion_sort(data, data + n, comp);
+  } else if (n < _radix_wide_threshold) {
+    psl::_radix_sort_lsd<_radix_narrow_bits, keys_only>(data, n, key);
+  } else {
+    psl::_radix_sort_lsd<_radix_wide_bits, keys_only>(data, n, key);
+  }
+}
+
+template <typename T, typename KeyFn>
+void _radix_sort_parallel(T* data, size_t n, KeyFn& key, int n_threads) {
+  using Key = decltype(radix_key(key(*data)));
+  constexpr int bits = _radix_wide_bits;
+  constexpr int n_passes = _radix_passes<Key, bits>;
+  constexpr size_t n_buckets = size_t(1) << bits;
+
+  auto max_threads = n / _radix_sort_parallel_grain;
+  if (size_t(n_threads) > max_threads)
+    n_threads = int(max_threads);
+  if (n_threads <= 1) {
+    psl::_radix_sort<false>(data, n, key);
+    return;
+  }
+
+  auto buffer = (T*)::operator new(sizeof(T) * n, std::align_val_t(alignof(T)));
+  // Each thread owns a contiguous chunk of the source and a row of counts for it
+  auto counts = psl::vector<size_t>(n_threads * n_buckets);
+  auto barrier = spin_barrier(n_threads);
+  auto skip = false;
+
+  psl::run_on_threads(n_threads, [&](int t) {
+    auto first = n * t / n_threads;
+    auto last = n * (t + 1) / n_threads;
+    auto row = &counts[t * n_buckets];
+    auto src = data, dst = buffer;
+
+    for (int p = 0; p < n_passes; p++) {
+      for (size_t b = 0; b < n_buckets; b++)
+        row[b] = 0;
+      for (size_t i = first; i < last; i++)
+        row[_radix_digit<bits>(src[i], key, p)]++;
+      barrier.arrive_and_wait();
+
+      if (t == 0) {
+        // Bucket b of thread t starts after bucket b of every earlier thread and every earlier
+        // bucket of all threads, which keeps the sort stable
+        skip = false;
+        for (size_t b = 0, sum = 0; b < n_buckets; b++) {
+          auto bucket_start = sum;
+          for (int i = 0; i < n_threads; i++) {
+            auto count = counts[i * n_buckets + b];
+            counts[i * n_buckets + b] = sum;
+            sum += count;
+          }
+          if (sum - bucket_start == n)
+            skip = true;
+        }
+      }
+      barrier.arrive_and_wait();
+
+      if (!skip) {
+        _radix_scatter<bits>(src + first, dst, last - first, row, key, p);
+        psl::swap(src, dst);
+      }
+      barrier.arrive_and_wait();
+    }
+
+    if (src != data)
+      for (size_t i = first; i < last; i++) {
+        psl::construct_at(data + i, psl::move(src[i]));
+        psl::destruct_at(src + i);
+      }
+  });
+
+  ::operator delete(buffer, std::align_val_t(alignof(T)));
+}
+
+template <typename T>
+concept RadixSortable = requires(T x) { psl::radix_key(x); };
+
+// Stable LSD radix sort in O(n) time with an n-element scratch buffer, 8 or 11 bits per pass.
+// Keys are uint32_t, uint64_t, int32_t, int64_t, float or double; `key` extracts one from each
+// element, and is called several times per element so it should be cheap. Passes over digits
+// that every key shares are skipped, and large ranges of bare keys that would still need more
+// than 5 passes, such as random 64-bit integers, are sorted with `psl::sort` instead
+template <Range R, typename KeyFn>
+requires RadixSortable<decltype(psl::declval<KeyFn&>()(*psl::begin(psl::declval<R&>())))>
+void radix_sort(R&& range, KeyFn&& key) {
+  auto first = psl::begin(range);
+  auto n = size_t(psl::end(range) - first);
+  if (n < 2)
+    return;
+  psl::_radix_sort<false>(&*first, n, key);
+}
+template <Range R>
+requires RadixSortable<IteratorValueType<IteratorTypeT<R>>>
+void radix_sort(R&& range) {
+  auto first = psl::begin(range);
+  auto n = size_t(psl::end(range) - first);
+  if (n < 2)
+    return;
+  auto key = [](auto x) { return x; };
+  psl::_radix_sort<true>(&*first, n, key);
+}
+
+// Same as `radix_sort` with the counting and scattering of every pass split across threads.
+// Ranges too small to keep `n_threads` busy use fewer threads
+template <Range R, typename KeyFn>
+requires RadixSortable<decltype(psl::declval<KeyFn&>()(*psl::begin(psl::declval<R&>())))>
+void radix_sort_parallel(R&& range, KeyFn&& key, int n_threads = thread::hardware_concurrency()) {
+  auto first = psl::begin(range);
+  auto n = size_t(psl::end(range) - first);
+  if (n < 2)
+    return;
+  psl::_radix_sort_parallel(&*first, n, key, n_threads);
+}
+template <Range R>
+requires RadixSortable<IteratorValueType<IteratorTypeT<R>>>
+void radix_sort_parallel(R&& range, int n_threads = thread::hardware_concurrency()) {
+  psl::radix_sort_parallel(range, [](auto x) { return x; }, n_threads);
+}
+
+}  // namespace psl
@@ -60,7 +60,7 @@ string& string::operator=(string rhs) {
   return *this;
 }
 void string::resize(size_t len) {
-  reserve(len + 1);
+  grow(len + 1);
   base::resize(len);
   data()[len] = '\0';
 }
@@ -0,0 +1,147 @@
+#include <psl/thread.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace psl {
+
+thread::thread(function<void()> f) {
+  handle = new std::thread([f = psl::move(f)]() { f(); });
+}
+thread::~thread() {
+  join();
+}
+thread& thread::operator=(thread&& rhs) {
+  join();
+  handle = rhs.handle;
+  rhs.handle = nullptr;
+  return *this;
+}
+
+void thread::join() {
+  if (handle) {
+    ((std::thread*)handle)->join();
+    delete (std::thread*)handle;
+    handle = nullptr;
+  }
+}
+
+int thread::hardware_concurrency() {
+  auto n = int(std::thread::hardware_concurrency());
+  return n > 0 ? n : 1;
+}
+
+void this_thread_yield() {
+  std::this_thread::yield();
+}
+
+void atomic_wait(const int* ptr, int old) {
+  std::atomic_ref<int>(*const_cast<int*>(ptr)).wait(old, std::memory_order_acquire);
+}
+void atomic_notify_all(int* ptr) {
+  std::atomic_ref<int>(*ptr).notify_all();
+}
+
+namespace {
+
+// Threads parked between calls of `run_on_threads`, so that a call doesn't pay for starting and
+// joining its threads. Each call takes idle workers for itself and starts more only when there
+// aren't enough, so concurrent calls still get a thread per index. The pool is never destroyed
+// and its workers are detached, so calls made during static destruction still work; it holds
+// std containers so that it never allocates from a pushed context allocator
+class ThreadPool {
+public:
+  void run(int n, function_ref<void(int)> f) {
+    auto workers = acquire(n - 1);
+    auto batch = Batch(n - 1);
+    for (int i = 1; i < n; i++)
+      workers[i - 1]->start(&f, i, &batch);
+    f(0);
+    {
+      auto lock = std::unique_lock(batch.mutex);
+      batch.done.wait(lock, [&] { return batch.pending == 0; });
+    }
+    release(workers);
+  }
+
+private:
+  struct Batch {
+    explicit Batch(int pending) : pending(pending) {
+    }
+
+    int pending;
+    std::mutex mutex;
+    std::condition_variable done;
+  };
+
+  struct Worker {
+    void start(function_ref<void(int)>* f, int index, Batch* batch) {
+      auto lock = std::lock_guard(mutex);
+      task = f;
+      this->index = index;
+      this->batch = batch;
+      wake.notify_one();
+    }
+
+    void loop() {
+      for (;;) {
+        auto lock = std::unique_lock(mutex);
+        wake.wait(lock, [this] { return task != nullptr; });
+        auto f = task;
+        task = nullptr;
+        lock.unlock();
+
+        (*f)(index);
+        // The caller may return and destroy `batch` as soon as `pending` drops to zero, which it
+        // can only see after this unlocks
+        auto batch_lock = std::lock_guard(batch->mutex);
+        if (--batch->pending == 0)
+          batch->done.notify_one();
+      }
+    }
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    function_ref<void(int)>* task = nullptr;
+    int index = 0;
+    Batch* batch = nullptr;
+  };
+
+  std::vector<Worker*> acquire(int n) {
+    auto workers = std::vector<Worker*>();
+    auto lock = std::lock_guard(mutex);
+    for (; n > 0 && !idle.empty(); n--) {
+      workers.push_back(idle.back());
+      idle.pop_back();
+    }
+    for (; n > 0; n--) {
+      auto worker = new Worker();
+      std::thread([worker] { worker->loop(); }).detach();
+      workers.push_back(worker);
+    }
+    return workers;
+  }
+  void release(const std::vector<Worker*>& workers) {
+    auto lock = std::lock_guard(mutex);
+    idle.insert(idle.end(), workers.begin(), workers.end());
+  }
+
+  std::mutex mutex;
+  std::vector<Worker*> idle;
+};
+
+}  // namespace
+
+void run_on_threads(int n, function_ref<void(int)> f) {
+  if (n <= 1) {
+    f(0);
+    return;
+  }
+  static auto pool = new ThreadPool();
+  pool->run(n, f);
+}
+
+}  // namespace psl
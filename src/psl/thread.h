@@ -0,0 +1,71 @@
+#pragma once
+
+#include <psl/function.h>
+#include <psl/atomic.h>
+
+namespace psl {
+
+class thread {
+public:
+  thread() = default;
+  explicit thread(function<void()> f);
+  ~thread();
+  thread(const thread&) = delete;
+  thread(thread&& rhs) {
+    handle = rhs.handle;
+    rhs.handle = nullptr;
+  }
+  thread& operator=(const thread&) = delete;
+  thread& operator=(thread&& rhs);
+
+  void join();
+  bool joinable() const {
+    return handle != nullptr;
+  }
+
+  static int hardware_concurrency();
+
+private:
+  void* handle = nullptr;
+};
+
+void this_thread_yield();
+
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#endif
+}
+
+// Blocks until `n` threads have arrived, then releases all of them; reusable right away
+class spin_barrier {
+public:
+  explicit spin_barrier(int n) : n(n) {
+  }
+
+  void arrive_and_wait() {
+    auto gen = generation.load(memory_order::acquire);
+    if (count.fetch_add(1, memory_order::acq_rel) == n - 1) {
+      count.store(0, memory_order::relaxed);
+      generation.store(gen + 1, memory_order::release);
+    } else {
+      for (int spins = 0; generation.load(memory_order::acquire) == gen; spins++) {
+        if (spins < 64)
+          cpu_relax();
+        else
+          this_thread_yield();
+      }
+    }
+  }
+
+private:
+  atomic<int> count = 0;
+  atomic<int> generation = 0;
+  int n;
+};
+
+// Run `f(i)` for i in [0, n) with each call on its own thread; the calling thread runs `f(0)`.
+// The other threads come from a pool that keeps them parked between calls
+void run_on_threads(int n, function_ref<void(int)> f);
+
+}  // namespace psl
@@ -262,6 +262,12 @@ constexpr bool copy_assignable = requires(T x) { x = x; };
 template <typename T>
 constexpr bool move_assignable = requires(T x) { x = static_cast<T&&>(x); };
 
+// A type is trivially relocatable if moving it to a new address and ending the lifetime of the
+// source is equivalent to copying its bytes.
+// Specialize it for types that are not trivially copyable but don't point into themselves
+template <typename T>
+constexpr bool is_trivially_relocatable = __is_trivially_copyable(T);
+
 template <typename Derived, typename Base>
 constexpr bool derived_from = convertible<const Derived *, const Base *>;
 template <typename Derived, typename Base>
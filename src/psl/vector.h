@@ -9,8 +9,46 @@
 
 namespace psl {
 
-template <typename T>
+// Growth policies pick the capacity a vector moves to when it runs out of room; `required` is
+// always greater than `capacity`. Allocators choose one with a `growth` member type
+struct growth_2x {
+  static size_t next_capacity(size_t capacity, size_t required) {
+    return psl::max(capacity * 2, required);
+  }
+};
+// Lets a buffer reuse the space of the ones it freed earlier, and wastes at most a third of it
+struct growth_1_5x {
+  static size_t next_capacity(size_t capacity, size_t required) {
+    return psl::max(capacity + capacity / 2, required);
+  }
+};
+// For buffers filled once to a known size; appending one by one becomes quadratic
+struct growth_exact {
+  static size_t next_capacity(size_t, size_t required) {
+    return required;
+  }
+};
+template <size_t capacity>
+struct growth_fixed {
+  static size_t next_capacity(size_t, size_t) {
+    return capacity;
+  }
+};
+
+template <typename Allocator>
+struct AllocatorGrowth {
+  using Type = growth_2x;
+};
+template <typename Allocator>
+requires requires { typename Allocator::growth; }
+struct AllocatorGrowth<Allocator> {
+  using Type = typename Allocator::growth;
+};
+
+template <typename T, typename Growth = growth_2x>
 struct default_allocator {
+  using growth = Growth;
+
   T* alloc(size_t count) const {
     auto ptr = (T*)::operator new(sizeof(T) * count);
     psl_check(ptr != nullptr);
@@ -32,8 +70,10 @@ struct default_allocator {
   }
 };
 
-template <typename T>
+template <typename T, typename Growth = growth_2x>
 struct context_allocator {
+  using growth = Growth;
+
   T* alloc(size_t count) const {
     auto ptr = (T*)context_alloc(sizeof(T) * count);
     psl_check(ptr != nullptr);
@@ -57,6 +97,9 @@ struct context_allocator {
 
 template <typename T, size_t capacity>
 struct static_allocator {
+  // The storage never moves, so taking all of it at once saves relocating into the same place
+  using growth = growth_fixed<capacity>;
+
   T* alloc(size_t size [[maybe_unused]]) const {
     psl_check(size <= capacity);
     return reinterpret_cast<T*>(storage.ptr());
@@ -78,12 +121,11 @@ struct static_allocator {
   psl::Storage<sizeof(T) * capacity, alignof(T)> storage;
 };
 
-// TODO: use relocate
-
 template <typename T, typename Allocator = default_allocator<T>>
 class vector {
 public:
   using ValueType = T;
+  using Growth = typename AllocatorGrowth<Allocator>::Type;
 
   using Iterator = T*;
   using ConstIterator = const T*;
@@ -142,7 +184,7 @@ public:
   }
 
   void push_back(T x) {
-    reserve(size() + 1);
+    grow(size() + 1);
     len += 1;
     allocator.construct_at(&back(), psl::move(x));
   }
@@ -157,7 +199,7 @@ public:
 
   template <typename... Args>
   void emplace_back(Args&&... args) {
-    reserve(size() + 1);
+    grow(size() + 1);
     len += 1;
     allocator.construct_at(&back(), T(forward<Args>(args)...));
   }
@@ -184,53 +226,59 @@ public:
   }
 
   Iterator insert(Iterator it, T x) {
-    auto dist = it - begin();
-    push_back(psl::move(x));
-    it = begin() + dist;
-
-    auto i = psl::prev(end());
-    for (; i > it; --i)
-      psl::swap(*psl::prev(i), *i);
-
-    return it;
+    auto p = it - begin();
+    grow(size() + 1);
+    psl::relocate_overlapping(ptr + p + 1, ptr + p, size() - p);
+    allocator.construct_at(ptr + p, psl::move(x));
+    len += 1;
+    return begin() + p;
   }
   template <Range ARange>
   void insert_range(Iterator it, ARange&& range) {
     auto p = it - begin();
-    auto suffix = vector(it, end());
-    auto nlen = size() + psl::size(range);
-    resize_less(p);
-    reserve(nlen);
+    auto n = size_t(psl::size(range));
+    grow(size() + n);
+    psl::relocate_overlapping(ptr + p + n, ptr + p, size() - p);
     psl::copy_inplace(begin() + p, range);
-    psl::copy_inplace(begin() + p + psl::size(range), suffix);
-    len = nlen;
+    len += n;
   }
 
   void erase(Iterator it) {
     if (it == end())
       return;
-    while (psl::next(it) != end()) {
-      auto next = psl::next(it);
-      psl::swap(*it, *next);
-      ++it;
-    }
-    pop_back();
+    allocator.destruct_at(it);
+    psl::relocate_overlapping(it, it + 1, end() - (it + 1));
+    len -= 1;
   }
   void erase_range(Iterator first, Iterator last) {
     psl_check(first <= last);
     if (first == last)
       return;
-    while (last != end()) {
-      psl::swap(*first, *last);
-      ++first;
-      ++last;
-    }
-
-    resize(size() - (last - first));
+    for (auto it = first; it != last; ++it)
+      allocator.destruct_at(it);
+    psl::relocate_overlapping(first, last, end() - last);
+    len -= last - first;
+  }
+  // Erase in O(1) by moving the last element into the hole, which doesn't preserve the order.
+  // Returns `it`, which now holds the element that was last, so a loop can check it next
+  Iterator swap_remove(Iterator it) {
+    psl_check(it != end());
+    if (it != &back())
+      *it = psl::move(back());
+    pop_back();
+    return it;
+  }
+  // Erase every element satisfying `pred` in one pass, keeping the order of the rest.
+  // Returns the number of elements erased
+  size_t erase_if(auto&& pred) {
+    auto tail = psl::remove_if(*this, pred);
+    auto n = size_t(end() - tail);
+    resize_less(size() - n);
+    return n;
   }
 
   void resize(size_t nlen) {
-    reserve(nlen);
+    grow(nlen);
     for (size_t i = size(); i < nlen; ++i)
       allocator.construct_at(&ptr[i]);
     for (size_t i = nlen; i < size(); ++i)
@@ -244,19 +292,27 @@ public:
     len = nlen;
   }
 
+  // Make room for exactly `nreserved` elements, unless there's already as much
   void reserve(size_t nreserved) {
-    nreserved = roundup2(nreserved);
     if (nreserved <= reserved)
       return;
-
-    auto nptr = allocator.alloc(nreserved);
-    if (ptr) {
-      psl::memcpy(nptr, ptr, size() * sizeof(T));
-      allocator.free(ptr);
-    }
-
-    ptr = nptr;
-    reserved = nreserved;
+    reallocate(nreserved);
+  }
+  // Make room for at least `nreserved` elements as the growth policy sees fit; for appending
+  void grow(size_t nreserved) {
+    if (nreserved <= reserved)
+      return;
+    reallocate(Growth::next_capacity(reserved, nreserved));
+  }
+  // Give back the capacity beyond `size()`, to the extent the growth policy allows
+  void shrink_to_fit() {
+    auto nreserved = size() == 0 ? 0 : Growth::next_capacity(0, size());
+    if (nreserved >= reserved)
+      return;
+    if (nreserved == 0)
+      reset();
+    else
+      reallocate(nreserved);
   }
 
   void clear() {
@@ -341,6 +397,21 @@ public:
   }
 
 protected:
+  void reallocate(size_t nreserved) {
+    auto nptr = allocator.alloc(nreserved);
+    if (ptr && nptr != ptr) {
+      // Callers never shrink below `size()`; saying so keeps the compiler from warning about
+      // copies into a small buffer on paths where the sizes can't actually meet
+      if (size() > nreserved)
+        __builtin_unreachable();
+      psl::relocate(nptr, ptr, size());
+      allocator.free(ptr);
+    }
+
+    ptr = nptr;
+    reserved = nreserved;
+  }
+
   T* ptr = nullptr;
   size_t len = 0;
   size_t reserved = 0;
@@ -348,6 +419,12 @@ protected:
   Allocator allocator;
 };
 
+// The vector only holds a pointer to its heap buffer, so it can be relocated by copying its bytes
+template <typename T, typename Growth>
+constexpr bool is_trivially_relocatable<vector<T, default_allocator<T, Growth>>> = true;
+template <typename T, typename Growth>
+constexpr bool is_trivially_relocatable<vector<T, context_allocator<T, Growth>>> = true;
+
 template <typename T, size_t capacity>
 struct static_vector : vector<T, static_allocator<T, capacity>> {
   using vector<T, static_allocator<T, capacity>>::vector;
@@ -505,7 +582,7 @@ private:
     psl_check(!overflowed);
     psl_check(new_size >= st.size());
     dy.reserve(new_size);
-    psl::move_inplace(dy.begin(), st);
+    psl::relocate(dy.begin(), st.begin(), st.size());
     if (zero_init) {
       for (size_t i = st.size(); i < new_size; i++)
         psl::construct_at(&dy[i]);
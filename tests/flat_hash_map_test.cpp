@@ -0,0 +1,126 @@
+#include <pine/rng.h>
+#include <pine/log.h>
+
+#include <psl/flat_hash_map.h>
+#include <psl/unordered_map.h>
+#include <psl/string.h>
+
+using namespace pine;
+
+// Sends every key to one of 64 hashes, so long probe sequences through full groups, equal control
+// bytes and tombstones in the way are the common case rather than the rare one
+struct CollidingHash {
+  uint64_t operator()(int key) const {
+    return mix_bits(uint64_t(key % 64));
+  }
+};
+
+template <typename Map>
+void check_same(const Map &map, const psl::unordered_map<int, psl::string> &reference) {
+  CHECK_EQ(map.size(), reference.size());
+  auto n = size_t(0);
+  for (auto &[key, value] : map) {
+    auto it = reference.find(key);
+    CHECK(it != reference.end());
+    CHECK(value == it->second);
+    n++;
+  }
+  CHECK_EQ(n, reference.size());
+  for (auto &[key, value] : reference) {
+    auto it = map.find(key);
+    CHECK(it != map.end());
+    CHECK(it->second == value);
+  }
+}
+
+// Random inserts, overwrites, erases by key and by iterator, and lookups of present and missing
+// keys, against the std-backed map, with the hash in `Hash`
+template <typename Hash>
+void random_operations_match_reference() {
+  auto rng = RNG(1);
+  auto map = psl::flat_hash_map<int, psl::string, Hash>();
+  auto reference = psl::unordered_map<int, psl::string>();
+  for (int op = 0; op < 200000; op++) {
+    auto key = int(rng.next32u(3000));
+    auto value = psl::to_string(op);
+    switch (rng.next32u(6)) {
+      case 0: {
+        auto inserted = map.insert(key, value).second;
+        CHECK_EQ(inserted, reference.insert({key, value}).second);
+        break;
+      }
+      case 1:
+        map.insert_or_assign(key, value);
+        reference[key] = value;
+        break;
+      case 2:
+      case 3:
+        CHECK_EQ(map.erase(key), reference.erase(key) == 1);
+        break;
+      case 4:
+        if (auto it = map.find(key); it != map.end()) {
+          map.erase(it);
+          reference.erase(key);
+        }
+        break;
+      default:
+        CHECK_EQ(map.contains(key), reference.count(key) == 1);
+        break;
+    }
+    if (op % 20000 == 0)
+      check_same(map, reference);
+  }
+  check_same(map, reference);
+
+  auto copy = map;
+  check_same(copy, reference);
+  map.clear();
+  CHECK_EQ(map.size(), 0u);
+  CHECK(map.begin() == map.end());
+  check_same(copy, reference);
+}
+
+// A live set of fixed size whose keys are replaced one at a time. At 83% load most groups are
+// full, so erasing leaves tombstones, and inserts use up the empty slots until the table has to
+// clear the tombstones out; it must do so in place rather than by growing
+void churn_keeps_capacity() {
+  constexpr int n_live = 1700;
+  auto map = psl::flat_hash_map<int, int>();
+  for (int key = 0; key < n_live; key++)
+    map.insert(key, key);
+  auto capacity = map.capacity();
+  CHECK_EQ(capacity, 2048u);
+  for (int key = n_live; key < 300000; key++) {
+    CHECK(map.erase(key - n_live));
+    CHECK(map.insert(key, key).second);
+    CHECK_EQ(map.capacity(), capacity);
+  }
+  CHECK_EQ(map.size(), size_t(n_live));
+  for (int key = 300000 - n_live; key < 300000; key++)
+    CHECK_EQ(map.find(key)->second, key);
+}
+
+// Growing from empty through many rehashes keeps every entry, as does a `reserve` up front
+void growth_keeps_entries() {
+  auto map = psl::flat_hash_map<uint64_t, uint64_t>();
+  auto reserved = psl::flat_hash_map<uint64_t, uint64_t>();
+  reserved.reserve(100000);
+  auto capacity = reserved.capacity();
+  for (uint64_t i = 0; i < 100000; i++) {
+    map[i * 7919] = i;
+    reserved[i * 7919] = i;
+  }
+  CHECK_EQ(reserved.capacity(), capacity);
+  for (uint64_t i = 0; i < 100000; i++) {
+    CHECK_EQ(map.find(i * 7919)->second, i);
+    CHECK_EQ(reserved.find(i * 7919)->second, i);
+  }
+  CHECK(!map.contains(uint64_t(1)));
+}
+
+int main() {
+  random_operations_match_reference<psl::hasher<int>>();
+  random_operations_match_reference<CollidingHash>();
+  churn_keeps_capacity();
+  growth_keeps_entries();
+}
@@ -0,0 +1,227 @@
+#include <pine/parallel.h>
+#include <pine/noise.h>
+#include <pine/rng.h>
+#include <pine/log.h>
+
+#include <psl/vector.h>
+
+using namespace pine;
+
+// Table gradients stay deterministic and in range once more seeds have been used than the
+// lock-free table of `perlin_table` holds, including seeds first seen from several threads at once
+void table_gradients_beyond_capacity() {
+  constexpr int n_seeds = 3000;
+  auto p = vec2(3.3f, 7.7f);
+  auto q = vec3(1.2f, -4.5f, 2.6f);
+  auto first = psl::vector<float>(n_seeds);
+  parallel_for(n_seeds, [&](int seed) {
+    first[seed] = perlin_noise(p, seed, PerlinGradients::Table);
+  });
+
+  for (int seed = 0; seed < n_seeds; seed++) {
+    CHECK_EQ(perlin_noise(p, seed, PerlinGradients::Table), first[seed]);
+    auto x = perlin_noise(q, seed, PerlinGradients::Table);
+    CHECK_RANGE(x, 0.0f, 1.0f);
+  }
+
+  // Seeds past the lock-free table go through the batch kernels too
+  auto points = psl::vector<vec2>(37);
+  for (int i = 0; i < 37; i++)
+    points[i] = vec2(i * 0.37f, i * -0.91f);
+  auto results = psl::vector<float>(points.size());
+  for (int seed = n_seeds - 4; seed < n_seeds; seed++) {
+    perlin_noise(points, results, seed, PerlinGradients::Table);
+    for (size_t i = 0; i < points.size(); i++)
+      CHECK_LT(psl::abs(results[i] - perlin_noise(points[i], seed, PerlinGradients::Table)), 1e-5f);
+  }
+}
+
+// Points scattered over [-50, 50]^D, the same for every run
+template <typename V>
+psl::vector<V> scattered_points(int n) {
+  constexpr int D = sizeof(V) / sizeof(float);
+  auto rng = RNG(n);
+  auto points = psl::vector<V>(n);
+  for (auto &p : points)
+    for (int i = 0; i < D; i++)
+      p[i] = rng.nextf() * 100.0f - 50.0f;
+  return points;
+}
+
+// The batch kernels agree with the scalar overloads for both gradient modes, including the points
+// left over past the last whole group of 8
+template <typename V>
+void batch_perlin_matches_scalar() {
+  for (auto gradients : {PerlinGradients::Hashed, PerlinGradients::Table})
+    for (int n : {1, 7, 8, 13, 100, 1001}) {
+      auto points = scattered_points<V>(n);
+      auto results = psl::vector<float>(n);
+      for (int seed : {0, 5}) {
+        perlin_noise(points, results, seed, gradients);
+        for (int i = 0; i < n; i++)
+          CHECK_LT(psl::abs(results[i] - perlin_noise(points[i], seed, gradients)), 1e-6f);
+      }
+    }
+}
+
+// Largest difference between a baked window and `fbm` at its sample points
+float bake_error(const Array2df &array, const NoiseRegion2d &region, const FbmParams &params) {
+  auto error = 0.0f;
+  for_2d(array.size(), [&](vec2i j) {
+    auto p = (vec2(region.offset + j) + vec2(0.5f)) * region.spacing;
+    error = psl::max(error, psl::abs(array[j] - fbm(p, params)));
+  });
+  return error;
+}
+float bake_error(const Array3df &array, const NoiseRegion3d &region, const FbmParams &params) {
+  auto error = 0.0f;
+  for_3d(vec3i(array.size()), [&](vec3i j) {
+    auto p = (vec3(region.offset + j) + vec3(0.5f)) * region.spacing;
+    error = psl::max(error, psl::abs(array[vec3i64(j)] - fbm(p, params)));
+  });
+  return error;
+}
+
+// Baked windows that straddle tile and sign boundaries match `fbm` at their samples
+void bake_matches_fbm() {
+  auto region2 = NoiseRegion2d{vec2i(-100, 37), vec2(1 / 50.0f, 1 / 40.0f)};
+  auto array2 = Array2df(vec2i(150, 90));
+  auto params2 = FbmParams{.octaves = 5, .seed = 101, .octave_seed_step = 7};
+  bake_noise(array2, region2, params2);
+  CHECK_LT(bake_error(array2, region2, params2), 1e-6f);
+
+  auto region3 = NoiseRegion3d{vec3i(-7, 3, -20), vec3(1 / 20.0f, 3.7f, 0.3f)};
+  auto array3 = Array3df(vec3i64(40, 33, 20));
+  auto params3 = FbmParams{.octaves = 4, .seed = 102, .gradients = PerlinGradients::Table};
+  bake_noise(array3, region3, params3);
+  CHECK_LT(bake_error(array3, region3, params3), 1e-6f);
+}
+
+// A window that overlaps an earlier one takes the shared tiles from the cache, and those give back
+// exactly the samples the first bake did
+void bake_reuses_cached_tiles() {
+  auto params = FbmParams{.octaves = 3, .seed = 103};
+  auto spacing = vec2(0.37f, 0.11f);
+  auto first = Array2df(vec2i(200, 130));
+  auto first_region = NoiseRegion2d{vec2i(-64, -64), spacing};
+  bake_noise(first, first_region, params);
+
+  auto shift = vec2i(45, 70);
+  auto second = Array2df(vec2i(200, 130));
+  auto second_region = NoiseRegion2d{first_region.offset + shift, spacing};
+  bake_noise(second, second_region, params);
+  CHECK_LT(bake_error(second, second_region, params), 1e-6f);
+  for_2d(shift, first.size(), [&](vec2i j) { CHECK_EQ(second[j - shift], first[j]); });
+}
+
+// Once more tiles have been baked than the cache holds, the oldest are evicted and baked again
+// when a window needs them
+void bake_evicts_old_tiles() {
+  auto params = FbmParams{.octaves = 1, .seed = 104};
+  auto spacing = vec2(0.05f);
+  auto corner = Array2df(vec2i(100, 80));
+  auto corner_region = NoiseRegion2d{vec2i(-30, -20), spacing};
+  bake_noise(corner, corner_region, params);
+
+  // 33 x 33 tiles of 64 x 64 samples, more than the 1024 the cache keeps
+  auto sweep = Array2df(vec2i(33 * 64));
+  bake_noise(sweep, NoiseRegion2d{vec2i(5000, 5000), spacing}, params);
+
+  auto again = Array2df(corner.size());
+  bake_noise(again, corner_region, params);
+  for_2d(corner.size(), [&](vec2i j) { CHECK_EQ(again[j], corner[j]); });
+  CHECK_LT(bake_error(again, corner_region, params), 1e-6f);
+}
+
+// `f(p)` and its central differences with step `h` along each axis
+template <typename V, typename F>
+V central_differences(V p, float h, F f) {
+  constexpr int D = sizeof(V) / sizeof(float);
+  auto gradient = V();
+  for (int a = 0; a < D; a++) {
+    auto d = V();
+    d[a] = h;
+    gradient[a] = (f(p + d) - f(p - d)) / (2 * h);
+  }
+  return gradient;
+}
+
+// The analytic gradients follow central differences, the values are those of the plain overloads
+// bit for bit, and the batch versions agree with the scalar ones
+template <typename V>
+void gradients_match_differences() {
+  constexpr int D = sizeof(V) / sizeof(float);
+  auto points = scattered_points<V>(203);
+  for (auto lattice : {PerlinGradients::Hashed, PerlinGradients::Table}) {
+    auto noise = [&](V p) { return perlin_noise(p, 3, lattice); };
+    for (auto p : points) {
+      auto grad = perlin_noise_grad(p, 3, lattice);
+      CHECK_EQ(grad.value, noise(p));
+      auto differences = central_differences(p, 1e-3f, noise);
+      for (int a = 0; a < D; a++)
+        CHECK_LT(psl::abs(grad.gradient[a] - differences[a]), 1e-2f);
+    }
+
+    auto values = psl::vector<float>(points.size());
+    auto gradients = psl::vector<V>(points.size());
+    perlin_noise_grad(points, values, gradients, 3, lattice);
+    for (size_t i = 0; i < points.size(); i++) {
+      auto grad = perlin_noise_grad(points[i], 3, lattice);
+      CHECK_LT(psl::abs(values[i] - grad.value), 1e-6f);
+      for (int a = 0; a < D; a++)
+        CHECK_LT(psl::abs(gradients[i][a] - grad.gradient[a]), 1e-5f);
+    }
+  }
+
+  for (int octaves : {1, 2, 3}) {
+    auto params = FbmParams{.octaves = octaves, .seed = 11, .octave_seed_step = 3};
+    auto noise = [&](V p) { return fbm(p, params); };
+    for (auto p : points) {
+      auto grad = fbm_grad(p, params);
+      CHECK_EQ(grad.value, noise(p));
+      auto differences = central_differences(p, 1e-3f, noise);
+      for (int a = 0; a < D; a++)
+        CHECK_LT(psl::abs(grad.gradient[a] - differences[a]), 1e-2f);
+    }
+
+    auto values = psl::vector<float>(points.size());
+    auto gradients = psl::vector<V>(points.size());
+    fbm_grad(points, values, gradients, params);
+    for (size_t i = 0; i < points.size(); i++) {
+      auto grad = fbm_grad(points[i], params);
+      CHECK_LT(psl::abs(values[i] - grad.value), 1e-6f);
+      for (int a = 0; a < D; a++)
+        CHECK_LT(psl::abs(gradients[i][a] - grad.gradient[a]), 1e-5f);
+    }
+  }
+}
+
+// The simplex kernels take the scalar steps in order, so batch and scalar results are the same
+template <typename V>
+void batch_simplex_matches_scalar() {
+  auto params = FbmParams{.octaves = 5, .seed = 9, .octave_seed_step = 2};
+  for (int n : {1, 13, 1001}) {
+    auto points = scattered_points<V>(n);
+    auto results = psl::vector<float>(n);
+    simplex_noise(points, results, 4);
+    for (int i = 0; i < n; i++)
+      CHECK_EQ(results[i], simplex_noise(points[i], 4));
+    simplex_fbm(points, results, params);
+    for (int i = 0; i < n; i++)
+      CHECK_EQ(results[i], simplex_fbm(points[i], params));
+  }
+}
+
+int main() {
+  table_gradients_beyond_capacity();
+  batch_perlin_matches_scalar<vec2>();
+  batch_perlin_matches_scalar<vec3>();
+  bake_matches_fbm();
+  bake_reuses_cached_tiles();
+  bake_evicts_old_tiles();
+  gradients_match_differences<vec2>();
+  gradients_match_differences<vec3>();
+  batch_simplex_matches_scalar<vec2>();
+  batch_simplex_matches_scalar<vec3>();
+  batch_simplex_matches_scalar<vec4>();
+}
@@ -0,0 +1,76 @@
+#include <pine/rng.h>
+#include <pine/log.h>
+
+#include <psl/vector.h>
+#include <psl/cpu.h>
+
+using namespace pine;
+
+bool operator==(const RNG &a, const RNG &b) {
+  return a.s[0] == b.s[0] && a.s[1] == b.s[1];
+}
+
+// The span functions give what replaying each lane with `RNG` gives, element `i * N + k` coming
+// from lane k. Every lane has advanced once per block afterwards, the last one too when it's
+// partial
+template <int N, int M, typename T, typename Fill>
+void lanes_match_replay(int n, Fill fill) {
+  auto rng = RNGxN<N>(n);
+  auto expected = psl::vector<float>(n * M);
+  auto lanes = psl::vector<RNG>(N);
+  for (int k = 0; k < N; k++) {
+    lanes[k] = rng.lane(k);
+    for (int i = 0; i * N < n; i++)
+      for (int c = 0; c < M; c++) {
+        auto x = lanes[k].nextf();
+        if (i * N + k < n)
+          expected[(i * N + k) * M + c] = x;
+      }
+  }
+
+  auto out = psl::vector<T>(n);
+  fill(rng, out);
+  auto values = (const float *)out.data();
+  for (int i = 0; i < n * M; i++)
+    CHECK_EQ(values[i], expected[i]);
+  for (int k = 0; k < N; k++)
+    CHECK(rng.lane(k) == lanes[k]);
+}
+
+template <int N>
+void lanes_match_rng() {
+  for (int n : {0, 1, N - 1, N, 3 * N + 5, 100 * N + N / 2}) {
+    lanes_match_replay<N, 1, float>(n, [](auto &rng, auto &out) { rng.nextf(out); });
+    lanes_match_replay<N, 2, vec2>(n, [](auto &rng, auto &out) { rng.next2f(out); });
+    lanes_match_replay<N, 3, vec3>(n, [](auto &rng, auto &out) { rng.next3f(out); });
+  }
+}
+
+// The lanes start as the first N streams of `split` and `jump` moves them to the next N
+template <int N>
+void jump_takes_next_streams() {
+  auto streams = RNG(7).split(2 * N);
+  auto rng = RNGxN<N>(7);
+  for (int k = 0; k < N; k++)
+    CHECK(rng.lane(k) == streams[k]);
+  rng.jump();
+  for (int k = 0; k < N; k++)
+    CHECK(rng.lane(k) == streams[N + k]);
+}
+
+int main() {
+  auto check = [] {
+    lanes_match_rng<8>();
+    lanes_match_rng<16>();
+    jump_takes_next_streams<8>();
+    jump_takes_next_streams<16>();
+  };
+  check();
+#ifdef PSL_X86
+  // Again on the narrower paths, which a CPU that has the wider ones never takes otherwise
+  psl::set_max_cpu_level(psl::CpuLevel::Avx2);
+  check();
+  psl::set_max_cpu_level(psl::CpuLevel::Baseline);
+  check();
+#endif
+}